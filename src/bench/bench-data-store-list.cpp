@@ -0,0 +1,170 @@
+/**
+ * Lookup throughput of the data store member list while it is churned.
+ *
+ * One writer keeps the list at a fixed number of members by emplacing a new
+ * member and erasing the oldest unused one, as eviction does, while every
+ * reader looks up random members of the current window through a snapshot,
+ * acquires the ones it finds and checks it got the member it asked for.
+ * Writes are expected to cost the same for any list size, and reads to scale
+ * with the number of readers.
+ *
+ * usage: bench-data-store-list [members] [milliseconds per run] [max readers]
+ */
+#include "dynamic-subgraph/double-linked-list.hpp"
+#include "dynamic-subgraph/member-base.hpp"
+#include "dynamic-subgraph/members.hpp"
+
+#include "ipc/util.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+namespace cr = std::chrono;
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using Nodes = DoubleLinkedList<Node>;
+
+static void formatKey(char (&primaryKey)[64], size_t idx)
+{
+  std::snprintf(primaryKey, sizeof(primaryKey), "00000000-0000-0000-0000-%012zx", idx);
+}
+
+static NodeResponse makeResponse(size_t idx)
+{
+  char primaryKey[64];
+  formatKey(primaryKey, idx);
+
+  NodeResponse response{};
+  util::parseString(response.primaryKey, std::string(primaryKey));
+  util::parseString(response.name, "/bench/node_" + std::to_string(idx));
+
+  return response;
+}
+
+struct Result
+{
+  size_t lookups, hits, writes;
+};
+
+static Result run(Nodes &nodes, std::deque<Nodes::iterator> &live, std::atomic<size_t> &next, size_t nrMembers, size_t nrReaders, cr::milliseconds duration)
+{
+  std::atomic<bool> stop(false);
+  std::atomic<size_t> nrLookups(0ul), nrHits(0ul);
+
+  std::vector<std::thread> readers;
+  readers.reserve(nrReaders);
+  for (size_t idx = 0ul; idx < nrReaders; ++idx)
+    readers.emplace_back([&, idx]()
+    {
+      uint64_t state = 0x9E3779B97F4A7C15ull * (idx + 1ul);
+      size_t lookups = 0ul, hits = 0ul;
+      char primaryKey[64];
+      while (!stop.load(std::memory_order_relaxed))
+      {
+        // xorshift, the window also covers members that were just erased
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        const size_t end = next.load(std::memory_order_relaxed);
+        const size_t wanted = end - 1ul - state % std::min(end, nrMembers + nrMembers / 8ul);
+        formatKey(primaryKey, wanted);
+        const PrimaryKey key{std::string_view(primaryKey)};
+
+        ++lookups;
+        const Nodes::Snapshot snapshot = nodes.snapshot();
+        Nodes::iterator it = snapshot.find(key);
+        if (it == snapshot.end() || !it->useCounter.tryIncrease())
+          continue;
+
+        MemberPtr member = MAKE_MEMBER_PTR(it);
+        if (it->instance.mPrimaryKey != key)
+        {
+          std::fprintf(stderr, "looked up %s but got %s\n", primaryKey, it->instance.mPrimaryKey.toString().c_str());
+          std::exit(1);
+        }
+        ++hits;
+      }
+      nrLookups.fetch_add(lookups);
+      nrHits.fetch_add(hits);
+    });
+
+  size_t nrWrites = 0ul;
+  const cr::steady_clock::time_point end = cr::steady_clock::now() + duration;
+  while (cr::steady_clock::now() < end)
+  {
+    for (size_t i = 0ul; i < 64ul; ++i)
+    {
+      Nodes::iterator it = nodes.emplace_back(makeResponse(next.load()), 0ul);
+      // hands the initial use back, so the member is unused
+      { MemberPtr initialUse = MAKE_MEMBER_PTR(it); }
+      live.push_back(it);
+      next.fetch_add(1ul);
+
+      // a reader might be using the oldest one, then it is erased later
+      Nodes::iterator oldest = live.front();
+      live.pop_front();
+      if (!oldest->useCounter.tryEvict())
+      {
+        live.push_back(oldest);
+        continue;
+      }
+      nodes.erase(oldest);
+      ++nrWrites;
+    }
+  }
+  stop.store(true);
+  for (std::thread &reader: readers)
+    reader.join();
+  nodes.reclaim();
+
+  return Result{
+    .lookups = nrLookups.load(),
+    .hits = nrHits.load(),
+    .writes = nrWrites
+  };
+}
+
+int main(int argc, char **argv)
+{
+  const size_t nrMembers = (argc > 1 ? std::stoul(argv[1]) : 10000ul);
+  const cr::milliseconds duration(argc > 2 ? std::stoul(argv[2]) : 1000ul);
+  const size_t maxReaders = (argc > 3 ? std::stoul(argv[3]) : std::max(std::thread::hardware_concurrency(), 1u));
+
+  Nodes nodes;
+  std::deque<Nodes::iterator> live;
+  std::atomic<size_t> next(0ul);
+  for (; next.load() < nrMembers; next.fetch_add(1ul))
+  {
+    Nodes::iterator it = nodes.emplace_back(makeResponse(next.load()), 0ul);
+    { MemberPtr initialUse = MAKE_MEMBER_PTR(it); }
+    live.push_back(it);
+  }
+
+  const double seconds = cr::duration<double>(duration).count();
+  for (size_t nrReaders = 1ul; nrReaders <= maxReaders; nrReaders *= 2ul)
+  {
+    const Result result = run(nodes, live, next, nrMembers, nrReaders, duration);
+    std::printf(
+      "members: %zu  readers: %2zu  %8.2f Mlookups/s (%5.1f%% hits)  writer: %8.2f kchurns/s  %7.2f us/churn\n",
+      nrMembers, nrReaders,
+      static_cast<double>(result.lookups) / seconds / 1e6,
+      result.lookups ? 100.0 * static_cast<double>(result.hits) / static_cast<double>(result.lookups) : 0.0,
+      static_cast<double>(result.writes) / seconds / 1e3,
+      result.writes ? seconds * 1e6 / static_cast<double>(result.writes) : 0.0
+    );
+  }
+
+  const Nodes::PoolStatistics statistics = nodes.getPoolStatistics();
+  if (statistics.live != live.size())
+  {
+    std::fprintf(stderr, "%zu members alive, expected %zu\n", statistics.live, live.size());
+    return 1;
+  }
+
+  return 0;
+}
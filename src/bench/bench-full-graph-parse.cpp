@@ -0,0 +1,168 @@
+/**
+ * Time to turn a full graph query response into a graph view.
+ *
+ * The response is synthetic but has the shape of sample-graph-response.json:
+ * three quarters of the members are nodes, each publishing to and subscribing
+ * to two topics and sending to one other node, the rest are topics, one of
+ * which (/rosout) is ignored. Parsing and assembling the graph are timed
+ * separately, both are expected to grow linearly with the number of members.
+ *
+ * usage: bench-full-graph-parse [runs per size] [members...]
+ */
+#include "dynamic-subgraph/graph-query-parser.hpp"
+#include "dynamic-subgraph/member-base.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <chrono>
+namespace cr = std::chrono;
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+//! NOTE: the all zero key is the empty one, so the keys start at one
+static std::string formatKey(size_t idx)
+{
+  char primaryKey[64];
+  std::snprintf(primaryKey, sizeof(primaryKey), "00000000-0000-0000-0000-%012zx", idx + 1ul);
+  return primaryKey;
+}
+
+static std::string formatNode(size_t idx)
+{
+  const std::string name = "/bench/node_" + std::to_string(idx);
+  return
+    "{\"stateChangeTime\":1748936495,\"Services\":[\"" + name + "/get_parameters\",\"" + name + "/set_parameters\"],"
+    "\"name\":\"" + name + "\",\"bootcounter\":1,\"handle\":94402106669552,\"pid\":" + std::to_string(idx) + ","
+    "\"state\":3,\"primaryKey\":\"" + formatKey(idx) + "\"}";
+}
+
+static std::string formatTopic(size_t idx)
+{
+  return "{\"name\":\"/bench/topic_" + std::to_string(idx) + "\",\"primaryKey\":\"" + formatKey(idx) + "\"}";
+}
+
+static std::string formatEdge(size_t relIdx, const std::string &from, const std::string &to)
+{
+  return "{\"rel\":{\"active\":true,\"primaryKey\":\"" + formatKey(relIdx) + "\"},\"from\":" + from + ",\"to\":" + to + "}";
+}
+
+struct Response
+{
+  std::string text;
+  size_t nrVertices, nrEdges;
+};
+
+/**
+ * Members [0, nrNodes) are nodes, the remaining ones topics, the first topic
+ * is the ignored one.
+ */
+static Response makeResponse(size_t nrMembers)
+{
+  const size_t nrNodes = std::max(nrMembers * 3ul / 4ul, 1ul);
+  const size_t nrTopics = std::max(nrMembers - nrNodes, 1ul);
+  size_t relIdx = nrNodes + nrTopics;
+
+  std::string sub, active, pub, send, passive;
+  size_t nrEdges = 0ul;
+  for (size_t node = 0ul; node < nrNodes; ++node)
+  {
+    const std::string vertex = formatNode(node);
+    active += (node ? "," : "") + vertex;
+
+    for (size_t i = 0ul; i < 2ul; ++i)
+    {
+      const size_t pubTopic = nrNodes + (node * 2ul + i) % nrTopics;
+      const size_t subTopic = nrNodes + (node * 2ul + i + 1ul) % nrTopics;
+      pub += (pub.empty() ? "" : ",") + formatEdge(relIdx++, vertex, formatTopic(pubTopic));
+      sub += (sub.empty() ? "" : ",") + formatEdge(relIdx++, formatTopic(subTopic), vertex);
+      nrEdges += (pubTopic != nrNodes) + (subTopic != nrNodes);
+    }
+
+    if (nrNodes > 1ul)
+    {
+      send += (send.empty() ? "" : ",") + formatEdge(relIdx++, vertex, formatNode((node + 1ul) % nrNodes));
+      ++nrEdges;
+    }
+  }
+  for (size_t topic = nrNodes; topic < nrNodes + nrTopics; ++topic)
+    passive += (topic != nrNodes ? "," : "") + formatTopic(topic);
+
+  // every section ends with a null edge, as the optional matches of the query produce
+  const std::string nullEdge = "{\"rel\":null,\"from\":null,\"to\":null}";
+  Response response;
+  response.text =
+    "{\"results\":[{\"columns\":[\"result\"],\"data\":[{\"row\":[{"
+      "\"sub\":[" + sub + "," + nullEdge + "],"
+      "\"active\":[" + active + "],"
+      "\"pub\":[" + pub + "," + nullEdge + "],"
+      "\"send\":[" + send + (send.empty() ? "" : ",") + nullEdge + "],"
+      "\"passive\":[" + passive + "]"
+    "}],\"meta\":[null]}]}],\"errors\":[],\"lastBookmarks\":[\"FB:bench\"]}";
+  response.nrVertices = nrNodes + nrTopics - 1ul;
+  response.nrEdges = nrEdges;
+
+  return response;
+}
+
+int main(int argc, char **argv)
+{
+  const size_t nrRuns = (argc > 1 ? std::stoul(argv[1]) : 5ul);
+  std::vector<size_t> sizes;
+  for (int idx = 2; idx < argc; ++idx)
+    sizes.push_back(std::stoul(argv[idx]));
+  if (sizes.empty())
+    sizes = {1000ul, 10000ul, 50000ul};
+
+  for (size_t nrMembers: sizes)
+  {
+    const Response response = makeResponse(nrMembers);
+    const PrimaryKey ignoredTopic{std::string_view(formatKey(std::max(nrMembers * 3ul / 4ul, 1ul)))};
+
+    cr::duration<double> parseTime(0.0), assembleTime(0.0);
+    for (size_t run = 0ul; run < nrRuns; ++run)
+    {
+      std::istringstream stream(response.text);
+      GraphQuerySaxHandler handler;
+
+      const cr::steady_clock::time_point start = cr::steady_clock::now();
+      if (!json::json::sax_parse(stream, &handler))
+      {
+        std::fprintf(stderr, "failed to parse the response of %zu members\n", nrMembers);
+        return 1;
+      }
+      const cr::steady_clock::time_point parsed = cr::steady_clock::now();
+      const GraphView graph = assembleGraphView(handler, [&ignoredTopic](const PrimaryKey &primaryKey) { return primaryKey == ignoredTopic; });
+      const cr::steady_clock::time_point assembled = cr::steady_clock::now();
+      parseTime += parsed - start;
+      assembleTime += assembled - parsed;
+
+      size_t nrEdges = 0ul;
+      for (const MemberConnections &vertex: graph)
+        nrEdges += vertex.connections.size();
+      if (graph.size() != response.nrVertices || nrEdges != response.nrEdges)
+      {
+        std::fprintf(
+          stderr, "got %zu vertices and %zu edges, expected %zu and %zu\n",
+          graph.size(), nrEdges, response.nrVertices, response.nrEdges
+        );
+        return 1;
+      }
+    }
+
+    const double runs = static_cast<double>(nrRuns);
+    std::printf(
+      "members: %6zu  edges: %7zu  %8.2f MiB  parse: %9.3f ms  assemble: %8.3f ms\n",
+      nrMembers, response.nrEdges,
+      static_cast<double>(response.text.size()) / (1024.0 * 1024.0),
+      parseTime.count() * 1e3 / runs,
+      assembleTime.count() * 1e3 / runs
+    );
+  }
+
+  return 0;
+}
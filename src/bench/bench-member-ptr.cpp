@@ -0,0 +1,142 @@
+/**
+ * Throughput of copying and destroying MemberPtr across threads.
+ *
+ * shared:  every thread copies and drops the same member, i.e. all of them
+ *          work on one contended use counter
+ * private: every thread copies and drops its own member
+ * release: every thread takes its own member from zero uses to one and back,
+ *          so each iteration goes through the release hook
+ *
+ * Heap allocations are counted as well, none of the above should allocate.
+ *
+ * usage: bench-member-ptr [iterations per thread] [max threads]
+ */
+#include "dynamic-subgraph/double-linked-list.hpp"
+#include "dynamic-subgraph/member-base.hpp"
+#include "dynamic-subgraph/members.hpp"
+
+#include "ipc/util.hpp"
+
+#include <atomic>
+#include <chrono>
+namespace cr = std::chrono;
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+static std::atomic<size_t> gNrAllocations(0ul);
+
+void *operator new(std::size_t size)
+{
+  gNrAllocations.fetch_add(1ul, std::memory_order_relaxed);
+  if (void *memory = std::malloc(size))
+    return memory;
+  throw std::bad_alloc();
+}
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+
+static thread_local size_t tNrReleases = 0ul;
+
+static NodeResponse makeResponse(size_t idx)
+{
+  char primaryKey[64];
+  std::snprintf(primaryKey, sizeof(primaryKey), "00000000-0000-0000-0000-%012zx", idx);
+
+  NodeResponse response{};
+  util::parseString(response.primaryKey, std::string(primaryKey));
+  util::parseString(response.name, "/bench/node_" + std::to_string(idx));
+
+  return response;
+}
+
+static void run(const char *scenario, size_t nrThreads, size_t nrIterations, const std::function<void(size_t)> &work)
+{
+  std::vector<std::thread> threads;
+  threads.reserve(nrThreads);
+
+  const size_t allocationsBefore = gNrAllocations.load();
+  const cr::steady_clock::time_point start = cr::steady_clock::now();
+  for (size_t idx = 0ul; idx < nrThreads; ++idx)
+    threads.emplace_back(work, idx);
+  for (std::thread &thread: threads)
+    thread.join();
+  const cr::duration<double> elapsed = cr::steady_clock::now() - start;
+  //! NOTE: starting the threads allocates as well
+  const size_t nrAllocations = gNrAllocations.load() - allocationsBefore - nrThreads;
+
+  const double nrOperations = static_cast<double>(nrThreads * nrIterations);
+  std::printf(
+    "%-8s threads: %2zu  %8.2f Mops/s  %7.2f ns/op per thread  allocations/op: %.3f\n",
+    scenario, nrThreads,
+    nrOperations / elapsed.count() / 1e6,
+    elapsed.count() * 1e9 / nrIterations,
+    static_cast<double>(nrAllocations) / nrOperations
+  );
+}
+
+int main(int argc, char **argv)
+{
+  const size_t nrIterations = (argc > 1 ? std::stoul(argv[1]) : 2000000ul);
+  const size_t maxThreads = (argc > 2 ? std::stoul(argv[2]) : std::max(std::thread::hardware_concurrency(), 1u));
+
+  DoubleLinkedList<Node> nodes;
+  nodes.setReleaseHook([](const PrimaryKey &) { ++tNrReleases; });
+
+  std::vector<DoubleLinkedList<Node>::iterator> elements;
+  std::vector<MemberPtr> members;
+  for (size_t idx = 0ul; idx < maxThreads + 1ul; ++idx)
+  {
+    DoubleLinkedList<Node>::iterator it = nodes.emplace_back(makeResponse(idx), 0ul);
+    elements.push_back(it);
+    members.push_back(MAKE_MEMBER_PTR(it));
+  }
+
+  for (size_t nrThreads = 1ul; nrThreads <= maxThreads; nrThreads *= 2ul)
+  {
+    run("shared", nrThreads, nrIterations, [&members, nrIterations](size_t)
+    {
+      const MemberPtr &member = members.back();
+      for (size_t i = 0ul; i < nrIterations; ++i)
+      {
+        MemberPtr copy(member);
+        asm volatile("" :: "r"(&copy) : "memory");
+      }
+    });
+    run("private", nrThreads, nrIterations, [&members, nrIterations](size_t idx)
+    {
+      const MemberPtr &member = members[idx];
+      for (size_t i = 0ul; i < nrIterations; ++i)
+      {
+        MemberPtr copy(member);
+        asm volatile("" :: "r"(&copy) : "memory");
+      }
+    });
+  }
+
+  // from here on the elements have no uses left besides the ones taken below
+  members.clear();
+  for (size_t nrThreads = 1ul; nrThreads <= maxThreads; nrThreads *= 2ul)
+    run("release", nrThreads, nrIterations, [&elements, nrIterations](size_t idx)
+    {
+      DoubleLinkedList<Node>::iterator it = elements[idx];
+      tNrReleases = 0ul;
+      for (size_t i = 0ul; i < nrIterations; ++i)
+      {
+        it->useCounter.tryIncrease();
+        MemberPtr member = MAKE_MEMBER_PTR(it);
+      }
+      if (tNrReleases != nrIterations)
+      {
+        std::fprintf(stderr, "release hook called %zu instead of %zu times\n", tNrReleases, nrIterations);
+        std::exit(1);
+      }
+    });
+
+  return 0;
+}
@@ -0,0 +1,149 @@
+/**
+ * Heap allocations and time of the usual primary key operations, with the
+ * textual std::string keys used before and with PrimaryKey.
+ *
+ * parse:  key from the char array of an IPC response
+ * copy:   key copied into a proxy, as for every MemberProxy, edge and alert
+ * map:    key inserted into and looked up in an unordered_map, as by the
+ *         graph, watchlist and pending update maps
+ *
+ * usage: bench-primary-key [keys] [rounds]
+ */
+#include "primary-key.hpp"
+
+#include "ipc/common.hpp"
+
+#include <atomic>
+#include <chrono>
+namespace cr = std::chrono;
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+static std::atomic<size_t> gNrAllocations(0ul);
+
+void *operator new(std::size_t size)
+{
+  gNrAllocations.fetch_add(1ul, std::memory_order_relaxed);
+  if (void *memory = std::malloc(size))
+    return memory;
+  throw std::bad_alloc();
+}
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+
+using RawKey = char[MAX_STRING_SIZE];
+
+template<typename Key>
+struct Proxy
+{
+  Key  primaryKey;
+  bool isTopic;
+};
+
+static void run(const char *operation, const char *keyType, size_t nrOperations, const std::function<void()> &work)
+{
+  const size_t allocationsBefore = gNrAllocations.load();
+  const cr::steady_clock::time_point start = cr::steady_clock::now();
+  work();
+  const cr::duration<double> elapsed = cr::steady_clock::now() - start;
+  const size_t nrAllocations = gNrAllocations.load() - allocationsBefore;
+
+  std::printf(
+    "%-6s %-11s %8.2f ns/op  allocations/op: %.3f\n",
+    operation, keyType,
+    elapsed.count() * 1e9 / static_cast<double>(nrOperations),
+    static_cast<double>(nrAllocations) / static_cast<double>(nrOperations)
+  );
+}
+
+template<typename Key>
+static void runAll(const char *keyType, const std::vector<RawKey> &rawKeys, size_t nrRounds)
+{
+  const size_t nrKeys = rawKeys.size();
+  std::vector<Key> keys;
+  keys.reserve(nrKeys);
+  for (const RawKey &rawKey: rawKeys)
+    keys.push_back(Key(rawKey));
+
+  //! NOTE: the containers are sized up front, so only the keys allocate
+  std::vector<Key> parsed;
+  parsed.reserve(nrKeys);
+  run("parse", keyType, nrKeys * nrRounds, [&]()
+  {
+    for (size_t round = 0ul; round < nrRounds; ++round)
+    {
+      parsed.clear();
+      for (const RawKey &rawKey: rawKeys)
+        parsed.push_back(Key(rawKey));
+    }
+  });
+
+  std::vector<Proxy<Key>> proxies;
+  proxies.reserve(nrKeys);
+  run("copy", keyType, nrKeys * nrRounds, [&]()
+  {
+    for (size_t round = 0ul; round < nrRounds; ++round)
+    {
+      proxies.clear();
+      for (const Key &key: keys)
+        proxies.push_back(Proxy<Key>{.primaryKey = key, .isTopic = false});
+    }
+  });
+
+  std::unordered_map<Key, size_t> indices;
+  indices.reserve(nrKeys);
+  size_t nrFound = 0ul;
+  run("map", keyType, nrKeys * nrRounds, [&]()
+  {
+    for (size_t round = 0ul; round < nrRounds; ++round)
+    {
+      indices.clear();
+      for (size_t idx = 0ul; idx < nrKeys; ++idx)
+        indices.emplace(keys[idx], idx);
+      for (const Key &key: keys)
+        nrFound += indices.count(key);
+    }
+  });
+
+  if (nrFound != nrKeys * nrRounds || parsed.size() != nrKeys || proxies.size() != nrKeys)
+  {
+    std::fprintf(stderr, "%s: found %zu of %zu keys\n", keyType, nrFound, nrKeys * nrRounds);
+    std::exit(1);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const size_t nrKeys = (argc > 1 ? std::stoul(argv[1]) : 10000ul);
+  const size_t nrRounds = (argc > 2 ? std::stoul(argv[2]) : 100ul);
+
+  // the IPC hands out random v4 UUIDs
+  std::vector<RawKey> rawKeys(nrKeys);
+  uint64_t state = 0x9E3779B97F4A7C15ull;
+  for (RawKey &rawKey: rawKeys)
+  {
+    uint64_t words[2];
+    for (uint64_t &word: words)
+    {
+      state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+      word = state;
+    }
+    std::snprintf(
+      rawKey, sizeof(rawKey), "%08llx-%04llx-4%03llx-%04llx-%012llx",
+      static_cast<unsigned long long>(words[0] >> 32), static_cast<unsigned long long>((words[0] >> 16) & 0xFFFFull),
+      static_cast<unsigned long long>(words[0] & 0xFFFull), static_cast<unsigned long long>(words[1] >> 48),
+      static_cast<unsigned long long>(words[1] & 0xFFFFFFFFFFFFull)
+    );
+  }
+
+  runAll<std::string>("std::string", rawKeys, nrRounds);
+  runAll<PrimaryKey>("PrimaryKey", rawKeys, nrRounds);
+
+  return 0;
+}
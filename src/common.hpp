@@ -17,18 +17,41 @@ namespace cr = std::chrono;
 namespace fs = std::filesystem;
 #include <mutex>
 
+#include "primary-key.hpp"
+
 
 #define CONFIG_IPC                              "ipc"
 #define   CONFIG_PROJECT_ID                     "project-id"
 #define   CONFIG_RETRY_CONNECTION               "retry-connection"
 #define   CONFIG_RETRY_ATTEMPTS                 "retry-attempts"
 #define   CONFIG_RETRY_TIMEOUT                  "retry-timeout-ms"
+#define CONFIG_DATA_STORE                       "data-store"
+#define   CONFIG_DRAIN_UPDATES                  "drain-updates"
+#define   CONFIG_DRAIN_BUDGET                   "drain-budget-ms"
+#define   CONFIG_EVENT_DRIVEN                   "event-driven"
+#define   CONFIG_EVENT_QUEUE_CAPACITY           "event-queue-capacity"
+#define   CONFIG_TOPOLOGY_REFRESH               "topology-refresh-interval-s"
+#define   CONFIG_FULL_GRAPH_QUERY               "full-graph-query"
+#define   CONFIG_UPDATE_CHANNEL_CAPACITY        "update-channel-capacity"
+#define   CONFIG_NODE_ATTRIBUTES                "node-attributes"
+#define   CONFIG_TOPIC_ATTRIBUTES               "topic-attributes"
+#define   CONFIG_RETENTION_CAPACITY             "retention-capacity"
+#define   CONFIG_RETENTION_GRACE_PERIOD         "retention-grace-period-s"
+#define   CONFIG_RELEASE_QUEUE_CAPACITY         "release-queue-capacity"
+#define   CONFIG_UPDATE_SHARDS                  "update-shards"
+#define   CONFIG_UPDATE_SHARD_CAPACITY          "update-shard-capacity"
+#define   CONFIG_WARM_START_FILE                "warm-start-file"
+#define   CONFIG_WARM_START_INTERVAL            "warm-start-interval-s"
+#define   CONFIG_NEIGHBOURHOOD_HOPS             "neighbourhood-hops"
 #define CONFIG_ALERT_RATE                       "alert-rate"
 #define   CONFIG_NR_NORMALISATION_VALUES        "nr-normalisation-values"
 #define   CONFIG_ABORTION_CRITERIA_THRESHOLD    "abortion-criteria-threshold"
 #define CONFIG_BLINDSPOT_INTERVAL               "blindspot-interval"
 #define CONFIG_BLINDSPOT_CPU_THRESHOLD          "blindspot-cpu-threshold"
 #define CONFIG_WATCHLIST                        "initial-watchlist-members"
+#define CONFIG_NAME_RESOLVER                    "name-resolver"
+#define   CONFIG_MIN_BACKOFF                    "min-backoff-ms"
+#define   CONFIG_MAX_BACKOFF                    "max-backoff-ms"
 #define CONFIG_MOVING_WINDOW_SIZE               "moving-window-size"
 #define CONFIG_TARGET_FREQUENCY                 "target-frequency"
 
@@ -135,7 +158,6 @@ namespace fs = std::filesystem;
 
 
 using Timestamp = cr::system_clock::time_point;
-using PrimaryKey = std::string;
 
 template<typename T>
 std::ostream &operator<<(std::ostream &stream, const std::vector<T> &v)
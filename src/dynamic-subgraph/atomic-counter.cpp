@@ -1,37 +1,50 @@
 #include "dynamic-subgraph/atomic-counter.hpp"
 
-#include "common.hpp"
-#include "atomic-counter.hpp"
+#include <cassert>
 
 
-void AtomicCounter::increase()
+bool AtomicCounter::tryIncrease()
 {
-  const ScopeLock scopedLock(mValueMutex);
-  ++mValue;
+  size_t value = mValue.load(std::memory_order_relaxed);
+  do
+  {
+    if (value == EVICTED)
+      return false;
+  } while (!mValue.compare_exchange_weak(value, value + 1ul, std::memory_order_acquire, std::memory_order_relaxed));
+
+  return true;
 }
 
 void AtomicCounter::decrease()
 {
-  const ScopeLock scopedLock(mValueMutex);
-  if (mValue > 0ul)
-    --mValue;
-}
-
-size_t AtomicCounter::get()
-{
-  const ScopeLock scopedLock(mValueMutex);
-  return mValue;
-}
-
-bool AtomicCounter::nonZero()
-{
-  const ScopeLock scopedLock(mValueMutex);
-  return mValue > 0ul;
+  //! NOTE: every decrease has to match a use, so an unused or evicted
+  //!       counter means an unbalanced release; release builds never wrap
+  //!       around but ignore it instead
+  size_t value = mValue.load(std::memory_order_relaxed);
+  assert(value != 0ul && value != EVICTED);
+  while (value != 0ul && value != EVICTED)
+  {
+    if (value == 1ul && mpZeroHook)
+    {
+      //! NOTE: once the counter is zero the element owning it may be evicted
+      //!       at any time, so the key is copied while this use still keeps
+      //!       it alive; the hook itself outlives the element
+      const ZeroHook *hook = mpZeroHook;
+      const PrimaryKey key = mKey;
+      if (mValue.compare_exchange_weak(value, 0ul, std::memory_order_acq_rel, std::memory_order_relaxed))
+      {
+        (*hook)(key);
+        return;
+      }
+    }
+    else if (mValue.compare_exchange_weak(value, value - 1ul, std::memory_order_acq_rel, std::memory_order_relaxed))
+      return;
+  }
 }
 
 std::ostream &operator<<(std::ostream &stream, const AtomicCounter &counter)
 {
-  stream << counter.mValue;
+  stream << counter.get();
 
   return stream;
 }
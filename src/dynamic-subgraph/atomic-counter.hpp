@@ -1,47 +1,111 @@
 #pragma once
 
+#include "primary-key.hpp"
+
 #include <cstddef>
-#include <mutex>
+#include <cstdint>
+#include <atomic>
+#include <functional>
 #include <iostream>
 
 
+/**
+ * Lock free use counter, intrusively embedded into the data store elements.
+ *
+ * Increasing is relaxed, as a new use can only be derived from an existing
+ * one (or from the data store, which synchronises by itself); decreasing is
+ * acquire/release so whoever sees the counter reach zero also sees every
+ * access made through the uses that are gone.
+ *
+ * An optional hook is called by whichever thread takes the counter from one
+ * to zero, with the key the counter was tagged with, which the data store
+ * uses to learn about released members without scanning all of them. The
+ * hook runs after the counter reached zero, when the element may already be
+ * evicted, so it must not reference the element. It is owned by whoever owns
+ * the elements (i.e. one per list) and only referenced by the counters, so
+ * releasing neither copies nor allocates anything.
+ *
+ * Lookups that might race with the eviction of an unused element use
+ * tryIncrease, which fails once the evicting thread claimed the (zero)
+ * counter with tryEvict.
+ */
 class AtomicCounter
 {
+public:
+  using ZeroHook = std::function<void(const PrimaryKey &)>;
+  static constexpr size_t EVICTED = SIZE_MAX;
+
 public:
   AtomicCounter(
     size_t value = 0ul
   ):
-    mValue(value)
+    mValue(value),
+    mpZeroHook(nullptr)
   {}
   AtomicCounter(
     AtomicCounter &&other
   ):
-    mValue(other.mValue)
+    mValue(other.mValue.load(std::memory_order_relaxed)),
+    mpZeroHook(other.mpZeroHook),
+    mKey(other.mKey)
   {}
   AtomicCounter &operator=(
     AtomicCounter &&other
   )
   {
-    mValue = other.mValue;
+    mValue.store(other.mValue.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    mpZeroHook = other.mpZeroHook;
+    mKey = other.mKey;
     return *this;
   }
   AtomicCounter(
     const AtomicCounter &other
   ):
-    mValue(other.mValue)
+    mValue(other.mValue.load(std::memory_order_relaxed)),
+    mpZeroHook(other.mpZeroHook),
+    mKey(other.mKey)
   {}
   AtomicCounter &operator=(
     const AtomicCounter &other
   )
   {
-    mValue = other.mValue;
+    mValue.store(other.mValue.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    mpZeroHook = other.mpZeroHook;
+    mKey = other.mKey;
     return *this;
   }
 
-  void increase();
+  void increase() { mValue.fetch_add(1ul, std::memory_order_relaxed); }
+  /**
+   * @return false if the counter was claimed for eviction
+   */
+  bool tryIncrease();
+  /**
+   * @note asserts that the counter is in use, i.e. the release is balanced
+   */
   void decrease();
-  size_t get();
-  bool nonZero();
+  /**
+   * Claim an unused counter for eviction, after which tryIncrease fails.
+   *
+   * @return false if the counter is in use (again)
+   */
+  bool tryEvict()
+  {
+    size_t unused = 0ul;
+    return mValue.compare_exchange_strong(unused, EVICTED, std::memory_order_acq_rel, std::memory_order_relaxed);
+  }
+  size_t get() const { return mValue.load(std::memory_order_acquire); }
+  bool nonZero() const { return get() > 0ul; }
+
+  /**
+   * @param hook must outlive the counter
+   * @param key passed to hook
+   * @note not synchronised, set it before the counter is shared
+   */
+  void setZeroHook(
+    const ZeroHook *hook,
+    const PrimaryKey &key
+  ) { mpZeroHook = hook; mKey = key; }
 
   friend std::ostream &operator<<(
     std::ostream &stream,
@@ -49,7 +113,8 @@ public:
   );
 
 private:
-  size_t mValue;
-  std::mutex mValueMutex;
+  std::atomic<size_t> mValue;
+  const ZeroHook     *mpZeroHook;
+  PrimaryKey          mKey;
 };
 std::ostream &operator<<(std::ostream &stream, const AtomicCounter &counter);
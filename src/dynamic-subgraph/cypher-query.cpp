@@ -0,0 +1,114 @@
+#include "dynamic-subgraph/cypher-query.hpp"
+
+#include "common.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+
+bool packQuery(std::string_view query, CustomMemberRequest &oRequest)
+{
+  LOG_TRACE(LOG_VAR(query));
+
+  if (query.size() > MAX_QUERY_LENGTH)
+  {
+    LOG_ERROR("Query with " << query.size() << " characters exceeds maximum of " << MAX_QUERY_LENGTH << " characters.");
+    return false;
+  }
+
+  // zero filling takes care of the terminators of the last (partial) row and the one after
+  std::memset(oRequest.query, '\0', sizeof(oRequest.query));
+  for (size_t row = 0ul; row * MAX_STRING_SIZE < query.size(); ++row)
+  {
+    std::string_view line = query.substr(row * MAX_STRING_SIZE, MAX_STRING_SIZE);
+    std::copy(line.begin(), line.end(), oRequest.query[row]);
+  }
+
+  return true;
+}
+
+void setQuery(const PackedQuery &query, CustomMemberRequest &oRequest)
+{
+  std::memcpy(oRequest.query, query.data(), sizeof(oRequest.query));
+}
+
+static constexpr std::string_view cHopsPlaceholder = "{hops}";
+static constexpr std::string_view cCutPlaceholder = "{cut}";
+static constexpr std::string_view cKeysPlaceholder = "{keys}";
+//! NOTE: the placeholders are replaced, the rest of the text is sent as is;
+//!       it is kept this short as every character left over makes room for
+//!       another key, so the vertices are returned whole and every edge is
+//!       collected once together with its type
+static constexpr std::string_view cNeighbourhoodQuery = (
+  "MATCH p=(c)-[:publishing|subscribing|sending*0..{hops}]-(m) WHERE c.primaryKey IN[{keys}]{cut} WITH collect(DISTINCT m) AS ms "
+  "OPTIONAL MATCH (a)-[r]->(b) WHERE a IN ms AND b IN ms WITH ms,collect({t:type(r),from:a.primaryKey,to:b.primaryKey}) AS rs "
+  "RETURN{active:[m IN ms WHERE m:Active],passive:[m IN ms WHERE m:Passive],"
+    "pub:[r IN rs WHERE r.t='publishing'],sub:[r IN rs WHERE r.t='subscribing'],send:[r IN rs WHERE r.t='sending']} AS result"
+);
+//! NOTE: the ignored topics (see DataStore::checkTopicNameIgnored) are filtered
+//!       out of the response by the data store, but from two hops on paths
+//!       through them have to be cut off in the match, as about every node is
+//!       connected to them and the neighbourhood would cover the whole graph
+static constexpr std::string_view cIgnoredCut = " AND none(x IN nodes(p)[1..-1] WHERE x.name IN['/rosout','/parameter_events'])";
+
+static std::string quoteKey(const PrimaryKey &primaryKey)
+{
+  std::string output("'");
+  for (char character: primaryKey.toString())
+  {
+    if (character == '\\' || character == '\'')
+      output.push_back('\\');
+    output.push_back(character);
+  }
+  output.push_back('\'');
+
+  return output;
+}
+
+std::vector<std::string> makeNeighbourhoodQueries(const std::vector<PrimaryKey> &centres, size_t hops)
+{
+  LOG_TRACE(LOG_VAR(centres.size()) LOG_VAR(hops));
+
+  // everything but the keys is the same for every query
+  const size_t hopsAt = cNeighbourhoodQuery.find(cHopsPlaceholder);
+  const size_t keysAt = cNeighbourhoodQuery.find(cKeysPlaceholder);
+  const size_t cutAt = cNeighbourhoodQuery.find(cCutPlaceholder);
+  const size_t hopsEnd = hopsAt + cHopsPlaceholder.size();
+  const size_t keysEnd = keysAt + cKeysPlaceholder.size();
+  const std::string head = (
+    std::string(cNeighbourhoodQuery.substr(0ul, hopsAt)) +
+    std::to_string(hops) +
+    std::string(cNeighbourhoodQuery.substr(hopsEnd, keysAt - hopsEnd))
+  );
+  const std::string tail = (
+    std::string(cNeighbourhoodQuery.substr(keysEnd, cutAt - keysEnd)) +
+    std::string(hops >= 2ul ? cIgnoredCut : std::string_view()) +
+    std::string(cNeighbourhoodQuery.substr(cutAt + cCutPlaceholder.size()))
+  );
+
+  std::vector<std::string> output;
+  std::string keys;
+  for (const PrimaryKey &centre: centres)
+  {
+    std::string key = quoteKey(centre);
+    if (head.size() + key.size() + tail.size() > MAX_QUERY_LENGTH)
+    {
+      LOG_ERROR("Neighbourhood query for " << centre << " exceeds maximum of " << MAX_QUERY_LENGTH << " characters, skipping it.");
+      continue;
+    }
+
+    // start a new query, if the key does not fit into the current one anymore
+    if (!keys.empty() && head.size() + keys.size() + 1ul + key.size() + tail.size() > MAX_QUERY_LENGTH)
+    {
+      output.push_back(head + keys + tail);
+      keys.clear();
+    }
+    if (!keys.empty())
+      keys.push_back(',');
+    keys += key;
+  }
+  if (!keys.empty())
+    output.push_back(head + keys + tail);
+
+  return output;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "ipc/datastructs/information-datastructs.hpp"
+#include "ipc/common.hpp"
+
+#include "primary-key.hpp"
+
+#include <cstddef>
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+//! maximum number of characters a query packed into CustomMemberRequest::query can have
+constexpr size_t MAX_QUERY_LENGTH = MAX_ARRAY_SIZE * MAX_STRING_SIZE;
+
+//! query in the layout of CustomMemberRequest::query
+using PackedQuery = std::array<std::array<char, MAX_STRING_SIZE>, MAX_ARRAY_SIZE>;
+static_assert(sizeof(PackedQuery) == sizeof(CustomMemberRequest::query));
+
+/**
+ * Lay out a query literal the way CustomMemberRequest::query expects it, i.e.
+ * in consecutive rows of MAX_STRING_SIZE characters, at compile time.
+ *
+ * Full rows are not zero terminated, the text continues right in the next
+ * row; only the end of the text is followed by a terminator (unless it fills
+ * the very last row) and the rows after it are zero.
+ *
+ * @param query query text, at most MAX_QUERY_LENGTH characters (excluding the terminator)
+ */
+template<size_t N>
+consteval PackedQuery packQuery(
+  const char (&query)[N]
+)
+{
+  static_assert(N - 1ul <= MAX_QUERY_LENGTH, "query does not fit into CustomMemberRequest::query");
+
+  // value initialisation takes care of the terminators of the last (partial) row and the one after
+  PackedQuery packed{};
+  for (size_t i = 0ul; i < N - 1ul; ++i)
+    packed[i / MAX_STRING_SIZE][i % MAX_STRING_SIZE] = query[i];
+  return packed;
+}
+
+//! config value for CONFIG_FULL_GRAPH_QUERY selecting cFullGraphQuery
+#define FULL_GRAPH_QUERY_FULL       "full"
+//! config value for CONFIG_FULL_GRAPH_QUERY selecting cFullGraphProjectionQuery
+#define FULL_GRAPH_QUERY_PROJECTION "projection"
+
+/**
+ * The whole graph with complete vertex and relationship objects (see README).
+ */
+inline constexpr PackedQuery cFullGraphQuery = packQuery(
+  "OPTIONAL MATCH (a:Active) WHERE (a)-[:publishing]->() OR ()-[:subscribing]->(a) OR (a)-[:sending]->() OR ()-[:sending]->(a) OR (a)-[:timer]->() WITH a "
+  "OPTIONAL MATCH (p:Passive) WHERE ()-[:publishing]->(p) OR (p)-[:subscribing]->() WITH a,p "
+  "OPTIONAL MATCH (a)-[pub:publishing]->(p) WITH a,p,pub "
+  "OPTIONAL MATCH (p)-[sub:subscribing]->(a) WITH a,p,pub,sub "
+  "OPTIONAL MATCH (a)-[send:sending]->(target) "
+  "RETURN { "
+    "active: collect(DISTINCT a), "
+    "passive: collect(DISTINCT p), "
+    "pub: collect(DISTINCT { from: startNode(pub), to: endNode(pub), rel: pub}), "
+    "sub: collect(DISTINCT { from: startNode(sub), to: endNode(sub), rel: sub}), "
+    "send: collect(DISTINCT { from: startNode(send), to: endNode(send), rel: send}) "
+  "} AS result"
+);
+
+/**
+ * Same as cFullGraphQuery, but only returns the primary keys of the vertices
+ * and edge endpoints, which is all the blind spot check needs.
+ */
+inline constexpr PackedQuery cFullGraphProjectionQuery = packQuery(
+  "OPTIONAL MATCH (a:Active) WHERE (a)-[:publishing]->() OR ()-[:subscribing]->(a) OR (a)-[:sending]->() OR ()-[:sending]->(a) OR (a)-[:timer]->() WITH a "
+  "OPTIONAL MATCH (p:Passive) WHERE ()-[:publishing]->(p) OR (p)-[:subscribing]->() WITH a,p "
+  "OPTIONAL MATCH (a)-[pub:publishing]->(p) WITH a,p,pub "
+  "OPTIONAL MATCH (p)-[sub:subscribing]->(a) WITH a,p,pub,sub "
+  "OPTIONAL MATCH (a)-[send:sending]->(target) "
+  "RETURN { "
+    "active: collect(DISTINCT a.primaryKey), "
+    "passive: collect(DISTINCT p.primaryKey), "
+    "pub: collect(DISTINCT { from: startNode(pub).primaryKey, to: endNode(pub).primaryKey}), "
+    "sub: collect(DISTINCT { from: startNode(sub).primaryKey, to: endNode(sub).primaryKey}), "
+    "send: collect(DISTINCT { from: startNode(send).primaryKey, to: endNode(send).primaryKey}) "
+  "} AS result"
+);
+
+/**
+ * Runtime counterpart to packQuery for query texts not known at compile time,
+ * with the same layout.
+ *
+ * @param query query text, at most MAX_QUERY_LENGTH characters
+ * @param oRequest request to write the query into
+ * @return false if the query does not fit, in which case oRequest is untouched
+ */
+bool packQuery(
+  std::string_view query,
+  CustomMemberRequest &oRequest
+);
+
+/**
+ * Copy a query packed at compile time into a request.
+ */
+void setQuery(
+  const PackedQuery &query,
+  CustomMemberRequest &oRequest
+);
+
+/**
+ * Build the queries for the neighbourhood of the given members, i.e. every
+ * member at most hops edges away (a node and the topics it publishes to are
+ * one edge apart, paths through the ignored topics don't count) together
+ * with its metadata and the edges between all of them, in the shape of the
+ * full graph query (see README). The ignored topics themselves are part of
+ * the result and have to be filtered out by the caller.
+ *
+ * The primary keys are inlined into the query text, which leaves room for
+ * about 13 (15 with less than two hops) of them per query; N centres take
+ * ceil(N / 13) queries.
+ *
+ * @param centres primary keys of the members to start from
+ * @param hops maximum distance from any of the centres
+ * @return query texts, each at most MAX_QUERY_LENGTH characters
+ */
+std::vector<std::string> makeNeighbourhoodQueries(
+  const std::vector<PrimaryKey> &centres,
+  size_t hops
+);
@@ -1,4 +1,6 @@
 #include "dynamic-subgraph/data-store.hpp"
+#include "dynamic-subgraph/graph-query-parser.hpp"
+#include "dynamic-subgraph/cypher-query.hpp"
 
 #include "common.hpp"
 
@@ -11,74 +13,323 @@ namespace json = nlohmann;
 
 #include <cassert>
 #include <optional>
+#include <future>
 #include <chrono>
 namespace cr = std::chrono;
 #include <thread>
 #include <unistd.h>
+#include <cerrno>
 #include <cstring>
 #include <algorithm>
+#include <istream>
+#include <unordered_map>
+#include <unordered_set>
+#include <iterator>
+#include <type_traits>
 
 
 DataStore::DataStore(const json::json &config):
-  mIpcClient(tryMakeIpcClient(config.at(CONFIG_IPC)))
+  mUpdateChannel(config.at(CONFIG_DATA_STORE).at(CONFIG_UPDATE_CHANNEL_CAPACITY).get<size_t>()),
+  mUpdatesSpilled(false),
+  mIpcReactor(tryMakeIpcClient(config.at(CONFIG_IPC))),
+  mIgnoredTopics{},
+  mpIgnoredTopics(&mIgnoredTopics[0]),
+  mWarmStartDiscarded(false),
+  mWarmStartWrittenAt(cr::system_clock::now()),
+  mTopologySeeded(false),
+  mTopologySeeding(false),
+  mBacklogDepth(0ul),
+  mReceivedUpdates(config.at(CONFIG_DATA_STORE).at(CONFIG_EVENT_QUEUE_CAPACITY).get<size_t>()),
+  mNrBlockedReaders(0ul),
+  mReleaseQueue(config.at(CONFIG_DATA_STORE).at(CONFIG_RELEASE_QUEUE_CAPACITY).get<size_t>()),
+  mReleaseQueueOverflowed(false),
+  mNrRetained(0ul),
+  mRetentionHits(0ul),
+  mRetentionMisses(0ul),
+  cmDrainUpdates(config.at(CONFIG_DATA_STORE).at(CONFIG_DRAIN_UPDATES).get<bool>()),
+  cmDrainBudget(config.at(CONFIG_DATA_STORE).at(CONFIG_DRAIN_BUDGET).get<size_t>()),
+  cmEventDriven(config.at(CONFIG_DATA_STORE).at(CONFIG_EVENT_DRIVEN).get<bool>()),
+  cmTopologyRefreshInterval(config.at(CONFIG_DATA_STORE).at(CONFIG_TOPOLOGY_REFRESH).get<size_t>()),
+  cmFullGraphRequest(makeFullGraphRequest(config.at(CONFIG_DATA_STORE).at(CONFIG_FULL_GRAPH_QUERY).get<std::string>())),
+  cmNodeAttributes(parseAttributeNames(config.at(CONFIG_DATA_STORE).at(CONFIG_NODE_ATTRIBUTES))),
+  cmTopicAttributes(parseAttributeNames(config.at(CONFIG_DATA_STORE).at(CONFIG_TOPIC_ATTRIBUTES))),
+  cmRetentionCapacity(config.at(CONFIG_DATA_STORE).at(CONFIG_RETENTION_CAPACITY).get<size_t>()),
+  cmRetentionGracePeriod(config.at(CONFIG_DATA_STORE).at(CONFIG_RETENTION_GRACE_PERIOD).get<size_t>()),
+  cmShardWorkers(config.at(CONFIG_DATA_STORE).at(CONFIG_UPDATE_SHARDS).get<size_t>() > 0ul),
+  cmWarmStartPath(config.at(CONFIG_DATA_STORE).at(CONFIG_WARM_START_FILE).get<std::string>()),
+  cmWarmStartInterval(config.at(CONFIG_DATA_STORE).at(CONFIG_WARM_START_INTERVAL).get<size_t>()),
+  cmNeighbourhoodHops(config.at(CONFIG_DATA_STORE).at(CONFIG_NEIGHBOURHOOD_HOPS).get<size_t>())
 {
   LOG_TRACE(LOG_THIS LOG_VAR(config));
 
-  requestId_t searchRequestId;
-  SearchRequest req{
-    .type = SearchRequest::TOPIC
-  };
+  //! NOTE: without update workers there still is one shard
+  const size_t nrShards = std::max(config.at(CONFIG_DATA_STORE).at(CONFIG_UPDATE_SHARDS).get<size_t>(), 1ul);
+  const size_t updateShardCapacity = config.at(CONFIG_DATA_STORE).at(CONFIG_UPDATE_SHARD_CAPACITY).get<size_t>();
+  mShards.reserve(nrShards);
+  for (size_t i = 0ul; i < nrShards; ++i)
+  {
+    MemberShard &shard = *mShards.emplace_back(std::make_unique<MemberShard>(updateShardCapacity));
+    //! NOTE: lets evictUnused only look at members which actually got released
+    shard.nodes.setReleaseHook([this](const PrimaryKey &primaryKey) { this->enqueueRelease(primaryKey, false); });
+    shard.topics.setReleaseHook([this](const PrimaryKey &primaryKey) { this->enqueueRelease(primaryKey, true); });
+  }
+
+  if (!cmWarmStartPath.empty())
+    mpWarmStart = WarmStartFile::load(cmWarmStartPath);
 
-  util::parseString(req.name, "/rosout");
-  mIpcClient.sendSearchRequest(req, searchRequestId);
-  mTopicRosoutKey = util::parseString(mIpcClient.receiveSearchResponse().value().primaryKey);
-  while(mTopicRosoutKey.empty())
+  if (mpWarmStart)
+    this->loadWarmStart();
+  else
   {
-    std::this_thread::sleep_for(cr::milliseconds(100));
+    const std::atomic<bool> searchForever(true);
+    mIgnoredTopics[0] = this->searchIgnoredTopics(searchForever);
+  }
+}
+
+template<typename Iterator>
+void DataStore::retainIfUnused(Iterator it, bool isTopic, Timestamp::rep now)
+{
+  if (it->useCounter.nonZero())
+    return;
+
+  //! NOTE: counted before it is marked, so a concurrent revive never takes
+  //!       the count below zero
+  mNrRetained.fetch_add(1ul);
+  Timestamp::rep notReleased = 0;
+  if (!it->releasedAt.compare_exchange_strong(notReleased, now))
+  {
+    mNrRetained.fetch_sub(1ul);
+    return;
+  }
+  //! NOTE: a lookup might have acquired the member between the check above
+  //!       and marking it, without seeing the mark; then the mark is taken
+  //!       back, unless a later lookup did see it and revived the member,
+  //!       which accounted for it already
+  if (it->useCounter.nonZero())
+  {
+    Timestamp::rep released = now;
+    if (it->releasedAt.compare_exchange_strong(released, 0))
+    {
+      mNrRetained.fetch_sub(1ul);
+      return;
+    }
+  }
+
+  LOG_TRACE("Retaining " << it->instance);
+  mRetained.push_back(RetainedMember{
+    .primaryKey = it->instance.mPrimaryKey,
+    .isTopic = isTopic,
+    .releasedAt = now
+  });
+}
 
-    mIpcClient.sendSearchRequest(req, searchRequestId);
-    mTopicRosoutKey = util::parseString(mIpcClient.receiveSearchResponse().value().primaryKey);
+template<typename List>
+bool DataStore::evictRetained(const RetainedMember &retained, std::vector<requestId_t> &oUnsubscriptions)
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(retained.primaryKey));
+
+  List &list = this->getShard(retained.primaryKey).getList<List>();
+  //! NOTE: held until the element is erased, so it stays valid until then
+  const typename List::Snapshot snapshot = list.snapshot();
+  typename List::iterator it = snapshot.find(retained.primaryKey);
+  //! NOTE: if the member got revived (and possibly released again) in the
+  //!       meantime, this entry is stale
+  if (!it || it->releasedAt.load() != retained.releasedAt || !it->useCounter.tryEvict())
+    return false;
+
+  LOG_TRACE("Removing " << it->instance << "from data store");
+  {
+    //! NOTE: an unused member should not be watched anymore, this is just
+    //!       to make sure the subscriptions do not outlive it
+    const std::lock_guard<std::mutex> scopedLock(mAttributeSubscriptionMutex);
+    this->removeAttributeSources(&it->instance, oUnsubscriptions);
   }
+  //! NOTE: a requested subscription is cancelled once it is collected
+  const requestId_t requestId = it->requestId.load();
+  if (requestId != cNoSubscription && requestId != cSubscriptionRequested)
+    oUnsubscriptions.push_back(requestId);
+
+  list.erase(it);
+  mNrRetained.fetch_sub(1ul);
+
+  return true;
+}
 
-  util::parseString(req.name, "/parameter_events");
-  mIpcClient.sendSearchRequest(req, searchRequestId);
-  mTopicParameterEventsKey = util::parseString(mIpcClient.receiveSearchResponse().value().primaryKey);
-  while(mTopicParameterEventsKey.empty())
+template<typename Iterator>
+MemberPtr DataStore::acquire(Iterator it, bool subscribe)
+{
+  //! NOTE: the element is created with one use, which is handed to the first
+  //!       MemberPtr; every further lookup has to account for its own
+  //! NOTE: fails if the element is being evicted right now, in which case
+  //!       it is treated as unknown
+  if (!it->useCounter.tryIncrease())
+    return MemberPtr();
+  if (it->releasedAt.exchange(0) != 0)
   {
-    std::this_thread::sleep_for(cr::milliseconds(100));
+    LOG_TRACE("Reviving retained " << it->instance);
+    mNrRetained.fetch_sub(1ul);
+    mRetentionHits.fetch_add(1ul);
+  }
+  if (subscribe)
+    this->requestUpdateSubscription(it);
+
+  return MAKE_MEMBER_PTR(it);
+}
+
+template<typename List>
+MemberPtr DataStore::acquireKnown(const PrimaryKey &primary, bool subscribe)
+{
+  const typename List::Snapshot snapshot = this->getShard(primary).getList<List>().snapshot();
+  typename List::iterator it = snapshot.find(primary);
+  if (it == snapshot.end())
+    return MemberPtr();
+
+  return this->acquire(it, subscribe);
+}
+
+template<typename List>
+MemberPtr DataStore::acquireKnownName(const std::string &name)
+{
+  //! NOTE: the shards are partitioned by key, so the name could be in any
+  for (const std::unique_ptr<MemberShard> &shard: mShards)
+  {
+    const typename List::Snapshot snapshot = shard->getList<List>().snapshot();
+    typename List::iterator it = snapshot.findName(name);
+    if (it != snapshot.end())
+      return this->acquire(it);
+  }
+
+  return MemberPtr();
+}
+
+template<typename Iterator>
+void DataStore::requestUpdateSubscription(Iterator it)
+{
+  //! NOTE: only whoever hands out a queried member first requests it
+  requestId_t notSubscribed = cNoSubscription;
+  if (it->requestId.load() != cNoSubscription || !it->requestId.compare_exchange_strong(notSubscribed, cSubscriptionRequested))
+    return;
+
+  LOG_TRACE("Requesting update subscription of " << it->instance);
+  if constexpr (std::is_same_v<Iterator, Nodes::iterator>)
+  {
+    NodeRequest nodeRequest{
+      .updates = true
+    };
+    util::parseString(nodeRequest.primaryKey, it->instance.mPrimaryKey.toString());
+    std::future<NodeResponse> subscription = mIpcReactor.sendNodeRequest(nodeRequest);
+
+    const std::lock_guard<std::mutex> scopedLock(mPendingSubscriptionsMutex);
+    std::get<PendingSubscriptions<NodeResponse>>(mPendingSubscriptions).push_back(PendingSubscription<NodeResponse>{
+      .primaryKey = it->instance.mPrimaryKey,
+      .response = std::move(subscription)
+    });
+  }
+  else
+  {
+    TopicRequest topicRequest{
+      .updates = true
+    };
+    util::parseString(topicRequest.primaryKey, it->instance.mPrimaryKey.toString());
+    std::future<TopicResponse> subscription = mIpcReactor.sendTopicRequest(topicRequest);
+
+    const std::lock_guard<std::mutex> scopedLock(mPendingSubscriptionsMutex);
+    std::get<PendingSubscriptions<TopicResponse>>(mPendingSubscriptions).push_back(PendingSubscription<TopicResponse>{
+      .primaryKey = it->instance.mPrimaryKey,
+      .response = std::move(subscription)
+    });
+  }
+}
+
+template<typename Response>
+MemberPtr DataStore::insertResponse(const Response &response, bool updates)
+{
+  using List = std::conditional_t<std::is_same_v<Response, NodeResponse>, Nodes, Topics>;
+
+  //! NOTE: requests are not serialised, so another thread might have
+  //!       requested and inserted the same member in the meantime
+  MemberShard &shard = this->getShard(PrimaryKey(response.primaryKey));
+  List &list = shard.getList<List>();
+  const std::lock_guard<std::mutex> scopedLock(shard.insertMutex);
 
-    mIpcClient.sendSearchRequest(req, searchRequestId);
-    mTopicParameterEventsKey = util::parseString(mIpcClient.receiveSearchResponse().value().primaryKey);
+  {
+    const typename List::Snapshot snapshot = list.snapshot();
+    typename List::iterator it = snapshot.find(PrimaryKey(response.primaryKey));
+    if (it != snapshot.end())
+    {
+      MemberPtr member = this->acquire(it, false);
+      if (member.valid())
+      {
+        LOG_DEBUG(it->instance << " was inserted concurrently, dropping the duplicate response.");
+        // a member inserted by the neighbourhood query can take over our subscription
+        requestId_t notSubscribed = cNoSubscription;
+        if (updates && !it->requestId.compare_exchange_strong(notSubscribed, response.requestID))
+          mIpcReactor.sendUnsubscribeRequest(UnsubscribeRequest{.id = response.requestID});
+        return member;
+      }
+    }
   }
+
+  typename List::iterator it = list.emplace_back(response, response.requestID);
+  LOG_TRACE("Created " << it->instance);
+
+  return MAKE_MEMBER_PTR(it);
 }
 
 const MemberPtr DataStore::getNode(const PrimaryKey &primary)
 {
   LOG_TRACE(LOG_THIS LOG_VAR(primary));
 
-  Nodes::iterator it = mNodes.find(primary);
-  if (it != mNodes.end())
-    return MAKE_MEMBER_PTR(it);
+  MemberPtr member = this->acquireKnown<Nodes>(primary);
+  if (member.valid())
+    return member;
 
   return requestNode(primary, true);
 }
 
+Task<MemberPtr> DataStore::coGetNode(Executor &executor, PrimaryKey primary)
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(primary));
+
+  MemberPtr member = this->acquireKnown<Nodes>(primary);
+  if (member.valid())
+    co_return std::move(member);
+
+  mRetentionMisses.fetch_add(1ul);
+  NodeRequest request{
+    .updates = true
+  };
+  util::parseString(request.primaryKey, primary.toString());
+  NodeResponse response = co_await executor.wait(mIpcReactor.sendNodeRequest(request, executor.getNotifier()));
+
+  co_return this->insertResponse(response, true);
+}
+
 const MemberPtr DataStore::getNodeByName(const std::string &name)
 {
   LOG_TRACE(LOG_THIS LOG_VAR(name));
 
-  Nodes::iterator it = mNodes.findName(name);
-  if (it != mNodes.end())
-    return MAKE_MEMBER_PTR(it);
+  {
+    MemberPtr member = this->acquireKnownName<Nodes>(name);
+    if (member.valid())
+      return member;
+  }
+
+  //! NOTE: the warm start snapshot might know the key already, which saves
+  //!       the search, but the name has to be checked as it can be outdated
+  std::optional<PrimaryKey> knownKey = (mpWarmStart && !mWarmStartDiscarded.load() ? mpWarmStart->findName(name, false) : std::nullopt);
+  if (knownKey.has_value())
+  {
+    MemberPtr member = this->getNode(knownKey.value());
+    if (member.valid() && asNode(member)->mName == name)
+      return member;
+  }
 
-  requestId_t searchRequestId;
   SearchRequest req{
     .type = SearchRequest::NODE
   };
   util::parseString(req.name, name);
-  mIpcClient.sendSearchRequest(req, searchRequestId);
-
-  PrimaryKey primaryKey = util::parseString(mIpcClient.receiveSearchResponse().value().primaryKey);
+  PrimaryKey primaryKey(mIpcReactor.sendSearchRequest(req).get().primaryKey);
   LOG_TRACE("SearchRequest returned primary key: '" << primaryKey << "'");
   if (primaryKey.empty())
     return MemberPtr();
@@ -90,64 +341,69 @@ MemberPtr DataStore::requestNode(const PrimaryKey &primary, bool updates)
 {
   LOG_TRACE(LOG_THIS LOG_VAR(primary) LOG_VAR(updates));
 
+  mRetentionMisses.fetch_add(1ul);
   NodeRequest nodeRequest{
     .updates = updates
   };
-  util::parseString(nodeRequest.primaryKey, primary);
-  requestId_t requestId;
-  Nodes::iterator node;
-  {
-    const ScopeLock scopedLock(mTopicsMutex);
+  util::parseString(nodeRequest.primaryKey, primary.toString());
 
-    mIpcClient.sendNodeRequest(nodeRequest, requestId);
-    NodeResponse nodeResponse = mIpcClient.receiveNodeResponse().value();
-    node = mNodes.emplace_back(nodeResponse, requestId);
-  }
-  LOG_TRACE("Created node " << node->instance);
+  return this->insertResponse(mIpcReactor.sendNodeRequest(nodeRequest).get(), updates);
+}
 
-  SingleAttributesRequest req{
-    .attribute = AttributeName::CPU_UTILIZATION,
-    .direction = Direction::NONE,
-    .continuous = true
-  };
-  util::parseString(req.primaryKey, node->instance.mPrimaryKey);
-  mIpcClient.sendSingleAttributesRequest(req, requestId);
-  SingleAttributesResponse response = mIpcClient.receiveSingleAttributesResponse().value();
-  assert(requestId == response.requestID);
+const MemberPtr DataStore::getTopic(const PrimaryKey &primary)
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(primary));
 
-  LOG_TRACE("Added CPU utilisation attribute to " << node->instance << " with shared memory location: " << response.memAddress);
-  node->instance.addAttributeSource(std::to_string(AttributeName::CPU_UTILIZATION), response);
+  MemberPtr member = this->acquireKnown<Topics>(primary);
+  if (member.valid())
+    return member;
 
-  return MAKE_MEMBER_PTR(node);
+  return requestTopic(primary, true);
 }
 
-const MemberPtr DataStore::getTopic(const PrimaryKey &primary)
+Task<MemberPtr> DataStore::coGetTopic(Executor &executor, PrimaryKey primary)
 {
   LOG_TRACE(LOG_THIS LOG_VAR(primary));
 
-  Topics::iterator it = mTopics.find(primary);
-  if (it != mTopics.end())
-    return MAKE_MEMBER_PTR(it);
+  MemberPtr member = this->acquireKnown<Topics>(primary);
+  if (member.valid())
+    co_return std::move(member);
 
-  return requestTopic(primary, true);
+  mRetentionMisses.fetch_add(1ul);
+  TopicRequest request{
+    .updates = true
+  };
+  util::parseString(request.primaryKey, primary.toString());
+  TopicResponse response = co_await executor.wait(mIpcReactor.sendTopicRequest(request, executor.getNotifier()));
+
+  co_return this->insertResponse(response, true);
 }
 
 const MemberPtr DataStore::getTopicByName(const std::string &name)
 {
   LOG_TRACE(LOG_THIS LOG_VAR(name));
 
-  Topics::iterator it = mTopics.findName(name);
-  if (it != mTopics.end())
-    return MAKE_MEMBER_PTR(it);
+  {
+    MemberPtr member = this->acquireKnownName<Topics>(name);
+    if (member.valid())
+      return member;
+  }
+
+  //! NOTE: the warm start snapshot might know the key already, which saves
+  //!       the search, but the name has to be checked as it can be outdated
+  std::optional<PrimaryKey> knownKey = (mpWarmStart && !mWarmStartDiscarded.load() ? mpWarmStart->findName(name, true) : std::nullopt);
+  if (knownKey.has_value())
+  {
+    MemberPtr member = this->getTopic(knownKey.value());
+    if (member.valid() && asTopic(member)->mName == name)
+      return member;
+  }
 
-  requestId_t searchRequestId;
   SearchRequest req{
     .type = SearchRequest::TOPIC
   };
   util::parseString(req.name, name);
-  mIpcClient.sendSearchRequest(req, searchRequestId);
-
-  PrimaryKey primaryKey = util::parseString(mIpcClient.receiveSearchResponse().value().primaryKey);
+  PrimaryKey primaryKey(mIpcReactor.sendSearchRequest(req).get().primaryKey);
   LOG_TRACE("SearchRequest returned primary key: '" << primaryKey << "'");
   if (primaryKey.empty())
     return MemberPtr();
@@ -155,289 +411,711 @@ const MemberPtr DataStore::getTopicByName(const std::string &name)
     return requestTopic(primaryKey, true);
 }
 
+Task<MemberPtr> DataStore::coGetTopicByName(Executor &executor, std::string name)
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(name));
+
+  {
+    MemberPtr member = this->acquireKnownName<Topics>(name);
+    if (member.valid())
+      co_return std::move(member);
+  }
+
+  std::optional<PrimaryKey> knownKey = (mpWarmStart && !mWarmStartDiscarded.load() ? mpWarmStart->findName(name, true) : std::nullopt);
+  if (knownKey.has_value())
+  {
+    MemberPtr member = co_await this->coGetTopic(executor, knownKey.value());
+    if (member.valid() && asTopic(member)->mName == name)
+      co_return std::move(member);
+  }
+
+  SearchRequest req{
+    .type = SearchRequest::TOPIC
+  };
+  util::parseString(req.name, name);
+  SearchResponse response = co_await executor.wait(mIpcReactor.sendSearchRequest(req, executor.getNotifier()));
+  PrimaryKey primaryKey(response.primaryKey);
+  LOG_TRACE("SearchRequest returned primary key: '" << primaryKey << "'");
+  if (primaryKey.empty())
+    co_return MemberPtr();
+
+  co_return co_await this->coGetTopic(executor, primaryKey);
+}
+
 MemberPtr DataStore::requestTopic(const PrimaryKey &primary, bool updates)
 {
   LOG_TRACE(LOG_THIS LOG_VAR(primary) LOG_VAR(updates));
 
+  mRetentionMisses.fetch_add(1ul);
   TopicRequest topicRequest{
     .updates = updates
   };
-  util::parseString(topicRequest.primaryKey, primary);
-  requestId_t requestId;
-  Topics::iterator topic;
+  util::parseString(topicRequest.primaryKey, primary.toString());
+
+  return this->insertResponse(mIpcReactor.sendTopicRequest(topicRequest).get(), updates);
+}
+
+Members DataStore::getMany(const MemberProxies &proxies)
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(proxies));
+
+  Members output(proxies.size());
+  // responses still to come, with the indices into proxies/output waiting for them
+  std::vector<std::pair<std::future<NodeResponse>, std::vector<size_t>>> pendingNodes;
+  std::vector<std::pair<std::future<TopicResponse>, std::vector<size_t>>> pendingTopics;
+  std::unordered_map<PrimaryKey, size_t> requested;
+  // send requests for everything we don't know yet, without waiting for any response
+  for (size_t idx = 0ul; idx < proxies.size(); ++idx)
   {
-    const ScopeLock scopedLock(mTopicsMutex);
+    const MemberProxy &proxy = proxies[idx];
+    output[idx] = (proxy.mIsTopic ? this->acquireKnown<Topics>(proxy.mPrimaryKey) : this->acquireKnown<Nodes>(proxy.mPrimaryKey));
+    if (output[idx].valid())
+      continue;
+
+    auto [requestedIt, isNew] = requested.emplace(proxy.mPrimaryKey, (proxy.mIsTopic ? pendingTopics.size() : pendingNodes.size()));
+    if (!isNew)
+    {
+      // requested twice, share the response
+      (proxy.mIsTopic ? pendingTopics[requestedIt->second].second : pendingNodes[requestedIt->second].second).push_back(idx);
+      continue;
+    }
 
-    mIpcClient.sendTopicRequest(topicRequest, requestId);
-    TopicResponse topicResponse = mIpcClient.receiveTopicResponse().value();
-    topic = mTopics.emplace_back(topicResponse, requestId);
+    if (proxy.mIsTopic)
+    {
+      TopicRequest topicRequest{
+        .updates = true
+      };
+      util::parseString(topicRequest.primaryKey, proxy.mPrimaryKey.toString());
+      pendingTopics.emplace_back(mIpcReactor.sendTopicRequest(topicRequest), std::vector<size_t>{idx});
+    }
+    else
+    {
+      NodeRequest nodeRequest{
+        .updates = true
+      };
+      util::parseString(nodeRequest.primaryKey, proxy.mPrimaryKey.toString());
+      pendingNodes.emplace_back(mIpcReactor.sendNodeRequest(nodeRequest), std::vector<size_t>{idx});
+    }
   }
-  LOG_TRACE("Created topic " << topic->instance);
+  LOG_DEBUG("Sent " << pendingNodes.size() << " node and " << pendingTopics.size() << " topic requests.");
+  mRetentionMisses.fetch_add(pendingNodes.size() + pendingTopics.size());
 
-  SingleAttributesRequest req{
-    .attribute = AttributeName::CPU_UTILIZATION,
-    .direction = Direction::NONE,
-    .continuous = true
+  auto distribute = [&output](const std::vector<size_t> &indices, MemberPtr member)
+  {
+    for (size_t i = 1ul; i < indices.size(); ++i)
+      output[indices[i]] = member;
+    output[indices.front()] = std::move(member);
   };
-  util::parseString(req.primaryKey, topic->instance.mPrimaryKey);
-  mIpcClient.sendSingleAttributesRequest(req, requestId);
-  SingleAttributesResponse response = mIpcClient.receiveSingleAttributesResponse().value();
-  assert(requestId == response.requestID);
-
-  LOG_TRACE("Added CPU utilisation attribute to " << topic->instance << " with shared memory location: " << response.memAddress);
-  topic->instance.addAttributeSource(std::to_string(AttributeName::CPU_UTILIZATION), response);
+  for (auto &[response, indices]: pendingNodes)
+    distribute(indices, this->insertResponse(response.get(), true));
+  for (auto &[response, indices]: pendingTopics)
+    distribute(indices, this->insertResponse(response.get(), true));
 
-  return MAKE_MEMBER_PTR(topic);
+  return output;
 }
 
-DataStore::GraphView DataStore::getFullGraphView() const
+Members DataStore::getNeighbourhood(const MemberProxies &centres)
 {
-  LOG_TRACE(LOG_THIS);
+  LOG_TRACE(LOG_THIS LOG_VAR(centres));
 
-  // send a request for the whole graph structure
-  CustomMemberRequest req{
-    .query = {
-      {'O', 'P', 'T', 'I', 'O', 'N', 'A', 'L', ' ', 'M', 'A', 'T', 'C', 'H', ' ', '(', 'a', ':', 'A', 'c', 't', 'i', 'v', 'e', ')', ' ', 'W', 'H', 'E', 'R', 'E', ' ', '(', 'a', ')', '-', '[', ':', 'p', 'u', 'b', 'l', 'i', 's', 'h', 'i', 'n', 'g', ']', '-', '>', '(', ')', ' ', 'O', 'R', ' ', '(', ')', '-', '[', ':', 's', 'u'},
-      {'b', 's', 'c', 'r', 'i', 'b', 'i', 'n', 'g', ']', '-', '>', '(', 'a', ')', ' ', 'O', 'R', ' ', '(', 'a', ')', '-', '[', ':', 's', 'e', 'n', 'd', 'i', 'n', 'g', ']', '-', '>', '(', ')', ' ', 'O', 'R', ' ', '(', ')', '-', '[', ':', 's', 'e', 'n', 'd', 'i', 'n', 'g', ']', '-', '>', '(', 'a', ')', ' ', 'O', 'R', ' ', '('},
-      {'a', ')', '-', '[', ':', 't', 'i', 'm', 'e', 'r', ']', '-', '>', '(', ')', ' ', 'W', 'I', 'T', 'H', ' ', 'a', ' ', 'O', 'P', 'T', 'I', 'O', 'N', 'A', 'L', ' ', 'M', 'A', 'T', 'C', 'H', ' ', '(', 'p', ':', 'P', 'a', 's', 's', 'i', 'v', 'e', ')', ' ', 'W', 'H', 'E', 'R', 'E', ' ', '(', ')', '-', '[', ':', 'p', 'u', 'b'},
-      {'l', 'i', 's', 'h', 'i', 'n', 'g', ']', '-', '>', '(', 'p', ')', ' ', 'O', 'R', ' ', '(', 'p', ')', '-', '[', ':', 's', 'u', 'b', 's', 'c', 'r', 'i', 'b', 'i', 'n', 'g', ']', '-', '>', '(', ')', ' ', 'W', 'I', 'T', 'H', ' ', 'a', ',', 'p', ' ', 'O', 'P', 'T', 'I', 'O', 'N', 'A', 'L', ' ', 'M', 'A', 'T', 'C', 'H', ' '},
-      {'(', 'a', ')', '-', '[', 'p', 'u', 'b', ':', 'p', 'u', 'b', 'l', 'i', 's', 'h', 'i', 'n', 'g', ']', '-', '>', '(', 'p', ')', ' ', 'W', 'I', 'T', 'H', ' ', 'a', ',', 'p', ',', 'p', 'u', 'b', ' ', 'O', 'P', 'T', 'I', 'O', 'N', 'A', 'L', ' ', 'M', 'A', 'T', 'C', 'H', ' ', '(', 'p', ')', '-', '[', 's', 'u', 'b', ':', 's'},
-      {'u', 'b', 's', 'c', 'r', 'i', 'b', 'i', 'n', 'g', ']', '-', '>', '(', 'a', ')', ' ', 'W', 'I', 'T', 'H', ' ', 'a', ',', 'p', ',', 'p', 'u', 'b', ',', 's', 'u', 'b', ' ', 'O', 'P', 'T', 'I', 'O', 'N', 'A', 'L', ' ', 'M', 'A', 'T', 'C', 'H', ' ', '(', 'a', ')', '-', '[', 's', 'e', 'n', 'd', ':', 's', 'e', 'n', 'd', 'i'},
-      {'n', 'g', ']', '-', '>', '(', 't', 'a', 'r', 'g', 'e', 't', ')', ' ', 'R', 'E', 'T', 'U', 'R', 'N', ' ', '{', ' ', 'a', 'c', 't', 'i', 'v', 'e', ':', ' ', 'c', 'o', 'l', 'l', 'e', 'c', 't', '(', 'D', 'I', 'S', 'T', 'I', 'N', 'C', 'T', ' ', 'a', ')', ',', ' ', 'p', 'a', 's', 's', 'i', 'v', 'e', ':', ' ', 'c', 'o', 'l'},
-      {'l', 'e', 'c', 't', '(', 'D', 'I', 'S', 'T', 'I', 'N', 'C', 'T', ' ', 'p', ')', ',', ' ', 'p', 'u', 'b', ':', ' ', 'c', 'o', 'l', 'l', 'e', 'c', 't', '(', 'D', 'I', 'S', 'T', 'I', 'N', 'C', 'T', ' ', '{', ' ', 'f', 'r', 'o', 'm', ':', ' ', 's', 't', 'a', 'r', 't', 'N', 'o', 'd', 'e', '(', 'p', 'u', 'b', ')', ',', ' '},
-      {'t', 'o', ':', ' ', 'e', 'n', 'd', 'N', 'o', 'd', 'e', '(', 'p', 'u', 'b', ')', ',', ' ', 'r', 'e', 'l', ':', ' ', 'p', 'u', 'b', '}', ')', ',', ' ', 's', 'u', 'b', ':', ' ', 'c', 'o', 'l', 'l', 'e', 'c', 't', '(', 'D', 'I', 'S', 'T', 'I', 'N', 'C', 'T', ' ', '{', ' ', 'f', 'r', 'o', 'm', ':', ' ', 's', 't', 'a', 'r'},
-      {'t', 'N', 'o', 'd', 'e', '(', 's', 'u', 'b', ')', ',', ' ', 't', 'o', ':', ' ', 'e', 'n', 'd', 'N', 'o', 'd', 'e', '(', 's', 'u', 'b', ')', ',', ' ', 'r', 'e', 'l', ':', ' ', 's', 'u', 'b', '}', ')', ',', ' ', 's', 'e', 'n', 'd', ':', ' ', 'c', 'o', 'l', 'l', 'e', 'c', 't', '(', 'D', 'I', 'S', 'T', 'I', 'N', 'C', 'T'},
-      {' ', '{', ' ', 'f', 'r', 'o', 'm', ':', ' ', 's', 't', 'a', 'r', 't', 'N', 'o', 'd', 'e', '(', 's', 'e', 'n', 'd', ')', ',', ' ', 't', 'o', ':', ' ', 'e', 'n', 'd', 'N', 'o', 'd', 'e', '(', 's', 'e', 'n', 'd', ')', ',', ' ', 'r', 'e', 'l', ':', ' ', 's', 'e', 'n', 'd', '}', ')', ' ', '}', ' ', 'A', 'S', ' ', 'r', 'e'},
-      {'s', 'u', 'l', 't', '\0'},
-      {'\0'}
-    },
-    .continuous = false
-  };
-  requestId_t requestId;
-  mIpcClient.sendCustomMemberRequest(req, requestId);
-  CustomMemberResponse resp = mIpcClient.receiveCustomMemberResponse().value();
-  assert(resp.requestID == requestId);
-  LOG_TRACE(LOG_VAR(resp.memAddress));
-
-  // puzzle together query response from textual responses
-  std::string queryResponseString;
-  sharedMem::SHMChannel<sharedMem::Response> channel(resp.memAddress, false);
-  sharedMem::Response response = MAKE_RESPONSE;
-  size_t previousNumber = 0;
-  do {
-    channel.receive(response);
-    assert(response.header.type == sharedMem::ResponseType::TEXTUAL);
-    assert(previousNumber < response.textual.number);
-    previousNumber = response.textual.number;
-    if (response.textual.number % 10 == 0)
-      LOG_DEBUG("Receiving package " << response.textual.number << '/' << response.textual.total);
-
-    std::string responseLine = util::parseString(response.textual.line);
-    std::move(responseLine.begin(), responseLine.end(), std::back_inserter(queryResponseString));
-  } while (response.textual.number < response.textual.total);
-  LOG_TRACE("Full query response: " << queryResponseString);
-
-  // load query response as json and navigate to data of interest
-  json::json queryResponseData = json::json::parse(queryResponseString);
-  queryResponseData = queryResponseData.at("results");
-  queryResponseData = queryResponseData.at(0);
-  queryResponseData = queryResponseData.at("data");
-  queryResponseData = queryResponseData.at(0);
-  queryResponseData = queryResponseData.at("row");
-  queryResponseData = queryResponseData.at(0);
-  assert(queryResponseData.is_object());
-
-  // construct graph vertices
-  GraphView output;
-  PrimaryKey primaryKey;
-  for (const json::json &node: queryResponseData["active"])
+  Members output;
+  if (cmNeighbourhoodHops == 0ul || centres.empty())
+    return output;
+
+  std::vector<PrimaryKey> centreKeys;
+  centreKeys.reserve(centres.size());
+  for (const MemberProxy &centre: centres)
+    centreKeys.push_back(centre.mPrimaryKey);
+
+  // one query per about 13 centres, all of them sent before awaiting any
+  std::vector<std::future<CustomMemberResponse>> responses;
+  for (const std::string &query: makeNeighbourhoodQueries(centreKeys, cmNeighbourhoodHops))
   {
-    primaryKey = node["primaryKey"].get<PrimaryKey>();
-    LOG_TRACE("Adding Node to graph with " LOG_VAR(primaryKey));
-    output.emplace_back(MemberProxy(primaryKey, false), MemberProxies());
+    CustomMemberRequest req{
+      .query = {},
+      .continuous = false
+    };
+    //! NOTE: can't fail, the queries are built to fit
+    packQuery(query, req);
+    responses.push_back(mIpcReactor.sendCustomMemberRequest(req));
   }
-  for (const json::json &topic: queryResponseData["passive"])
+
+  //! NOTE: the neighbourhoods of different centres overlap, so the same
+  //!       member might be returned by several queries
+  std::unordered_set<PrimaryKey> seen;
+  for (std::future<CustomMemberResponse> &response: responses)
   {
-    primaryKey = topic["primaryKey"].get<PrimaryKey>();
-    if (this->checkTopicPrimaryIgnored(primaryKey))
+    const CustomMemberResponse resp = response.get();
+
+    // stream the textual responses straight into the parser
+    sharedMem::SHMChannel<sharedMem::Response> channel(resp.memAddress, false);
+    ShmTextStreamBuffer responseBuffer(channel);
+    std::istream responseStream(&responseBuffer);
+    GraphQuerySaxHandler handler(true);
+    if (!json::json::sax_parse(responseStream, &handler))
+    {
+      LOG_ERROR("Failed to parse neighbourhood query response.");
       continue;
+    }
+
+    const MemberProxies &vertices = handler.getVertices();
+    const std::vector<json::json> &properties = handler.getProperties();
+    for (size_t idx = 0ul; idx < vertices.size(); ++idx)
+    {
+      const MemberProxy &vertex = vertices[idx];
+      //! NOTE: the query returns the ignored topics, only paths through them are cut
+      if ((vertex.mIsTopic && this->checkTopicPrimaryIgnored(vertex.mPrimaryKey)) || !seen.insert(vertex.mPrimaryKey).second)
+        continue;
 
-    LOG_TRACE("Adding Topic to graph with " LOG_VAR(primaryKey));
-    output.emplace_back(MemberProxy(primaryKey, true), MemberProxies());
+      MemberPtr member = (vertex.mIsTopic ?
+        this->acquireKnown<Topics>(vertex.mPrimaryKey, false) :
+        this->acquireKnown<Nodes>(vertex.mPrimaryKey, false)
+      );
+      if (!member.valid())
+        member = (vertex.mIsTopic ?
+          this->insertResponse(makeTopicResponse(vertex.mPrimaryKey, properties[idx]), false) :
+          this->insertResponse(makeNodeResponse(vertex.mPrimaryKey, properties[idx]), false)
+        );
+      if (member.valid())
+        output.push_back(std::move(member));
+    }
+
+    // sub: topic -> node, pub: node -> topic, send: node -> node
+    for (const GraphQuerySaxHandler::Edge &edge: handler.getEdges())
+      this->applyTopologyEdge(
+        MemberProxy(edge.from, edge.type == GraphQuerySaxHandler::EDGE_SUB),
+        MemberProxy(edge.to, edge.type == GraphQuerySaxHandler::EDGE_PUB)
+      );
   }
+  LOG_DEBUG("Resolved the " << cmNeighbourhoodHops << " hop neighbourhood of " << centres.size() << " members to " << output.size() << " members.");
 
-  // construct graph edges
-  for (const json::json &sub: queryResponseData["sub"])
-  {
-    if (sub["rel"].is_null())
-      continue;
+  return output;
+}
 
-    std::string
-      fromPrimaryKey = sub["from"]["primaryKey"],
-      toPrimaryKey   = sub["to"]["primaryKey"];
-    if (this->checkTopicPrimaryIgnored(fromPrimaryKey))
-      continue;
+void DataStore::collectUpdateSubscriptions()
+{
+  this->collectUpdateSubscriptions<Nodes>(std::get<PendingSubscriptions<NodeResponse>>(mPendingSubscriptions));
+  this->collectUpdateSubscriptions<Topics>(std::get<PendingSubscriptions<TopicResponse>>(mPendingSubscriptions));
+}
+
+template<typename List, typename Response>
+void DataStore::collectUpdateSubscriptions(PendingSubscriptions<Response> &pending)
+{
+  PendingSubscriptions<Response> ready;
+  {
+    const std::lock_guard<std::mutex> scopedLock(mPendingSubscriptionsMutex);
 
-    GraphView::iterator it = std::find_if(
-      output.begin(), output.end(),
-      [&fromPrimaryKey](const GraphView::value_type &element) -> bool
+    typename PendingSubscriptions<Response>::iterator stillPending = std::stable_partition(
+      pending.begin(), pending.end(),
+      [](const PendingSubscription<Response> &subscription) -> bool
       {
-        return element.member.mPrimaryKey == fromPrimaryKey;
+        return subscription.response.wait_for(cr::seconds(0)) != std::future_status::ready;
       }
     );
-    LOG_TRACE("Adding sub connection from " << it->member << " to " << toPrimaryKey << "to graph");
-    assert(it != output.end());
-    it->connections.emplace_back(std::move(toPrimaryKey), false);
+    std::move(stillPending, pending.end(), std::back_inserter(ready));
+    pending.erase(stillPending, pending.end());
   }
-  for (const json::json &pub: queryResponseData["pub"])
+  if (ready.empty())
+    return;
+
+  std::vector<requestId_t> unsubscriptions;
+  for (PendingSubscription<Response> &subscription: ready)
   {
-    if (pub["rel"].is_null())
-      continue;
+    const Response response = subscription.response.get();
 
-    std::string
-      fromPrimaryKey = pub["from"]["primaryKey"],
-      toPrimaryKey   = pub["to"]["primaryKey"];
-    if (this->checkTopicPrimaryIgnored(toPrimaryKey))
+    const typename List::Snapshot snapshot = this->getShard(subscription.primaryKey).template getList<List>().snapshot();
+    typename List::iterator it = snapshot.find(subscription.primaryKey);
+    requestId_t requested = cSubscriptionRequested;
+    if (!it || !it->requestId.compare_exchange_strong(requested, response.requestID))
+    {
+      // evicted in the meantime, or it got a subscription of its own
+      unsubscriptions.push_back(response.requestID);
       continue;
+    }
+  }
+  LOG_DEBUG("Collected " << ready.size() - unsubscriptions.size() << " update subscriptions of queried members.");
+
+  this->sendUnsubscribeRequests(unsubscriptions);
+}
+
+void DataStore::subscribeAttributes(const Members &members)
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(members.size()));
+
+  const std::lock_guard<std::mutex> scopedLock(mAttributeSubscriptionMutex);
+
+  std::vector<Member *> unsubscribed = this->markSubscribed(members);
+  if (unsubscribed.empty())
+    return;
+
+  this->addAttributeSources(unsubscribed);
+}
+
+Task<void> DataStore::coSubscribeAttributes(Executor &executor, Members members)
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(members.size()));
+
+  //! NOTE: the lock can't be held while awaiting, so a subscription might
+  //!       be cancelled before its responses arrive, which is what the
+  //!       generation is checked for afterwards
+  std::vector<PendingAttribute> pending;
+  {
+    const std::lock_guard<std::mutex> scopedLock(mAttributeSubscriptionMutex);
+
+    pending = this->requestAttributeSources(this->markSubscribed(members), executor.getNotifier());
+  }
+
+  //! NOTE: waiting for the initial values blocks as well, so the shared
+  //!       memories are opened before taking the lock again
+  std::vector<Member::Attribute> attributes;
+  attributes.reserve(pending.size());
+  for (PendingAttribute &attribute: pending)
+  {
+    const SingleAttributesResponse response = co_await executor.wait(std::move(attribute.response));
+    attributes.push_back(Member::openAttributeSource(std::to_string(attribute.attribute), response));
+  }
+
+  std::vector<requestId_t> unsubscriptions;
+  {
+    const std::lock_guard<std::mutex> scopedLock(mAttributeSubscriptionMutex);
 
-    GraphView::iterator it = std::find_if(
-      output.begin(), output.end(),
-      [&fromPrimaryKey](const GraphView::value_type &element) -> bool
+    for (size_t idx = 0ul; idx < pending.size(); ++idx)
+    {
+      const PendingAttribute &attribute = pending[idx];
+      if (!attribute.member->mAttributesSubscribed || attribute.member->mAttributeGeneration != attribute.generation)
       {
-        return element.member.mPrimaryKey == fromPrimaryKey;
+        unsubscriptions.push_back(attributes[idx].requestId);
+        continue;
       }
-    );
-    LOG_TRACE("Adding pub connection from " << it->member << " to " << toPrimaryKey << "to graph");
-    assert(it != output.end());
-    it->connections.emplace_back(std::move(toPrimaryKey), true);
+
+      LOG_TRACE("Added attribute " << attribute.attribute << " to " << attribute.member);
+      attribute.member->addAttributeSource(std::move(attributes[idx]));
+    }
   }
-  for (const json::json &send: queryResponseData["send"])
+  this->sendUnsubscribeRequests(unsubscriptions);
+}
+
+std::vector<Member *> DataStore::markSubscribed(const Members &members)
+{
+  //! NOTE: expects mAttributeSubscriptionMutex to be locked
+  std::vector<Member *> output;
+  for (const MemberPtr &member: members)
   {
-    if (send["rel"].is_null())
+    if (!member.valid() || member.mpMember->mAttributesSubscribed)
       continue;
 
-    std::string
-      fromPrimaryKey = send["from"]["primaryKey"],
-      toPrimaryKey   = send["to"]["primaryKey"];
-    GraphView::iterator it = std::find_if(
-      output.begin(), output.end(),
-      [&fromPrimaryKey](const GraphView::value_type &element) -> bool
-      {
-        return element.member.mPrimaryKey == fromPrimaryKey;
-      }
-    );
-    LOG_TRACE("Adding send connection from " << it->member << " to " << toPrimaryKey << "to graph");
-    assert(it != output.end());
-    it->connections.emplace_back(std::move(toPrimaryKey), false);
+    // also takes care of duplicates
+    member.mpMember->mAttributesSubscribed = true;
+    output.push_back(member.mpMember);
   }
 
   return output;
 }
 
-DataStore::SharedMemory DataStore::getCpuUtilisationMemory() const
+void DataStore::unsubscribeAttributes(const Members &members)
 {
-  LOG_TRACE(LOG_THIS);
+  LOG_TRACE(LOG_THIS LOG_VAR(members.size()));
 
-  static_assert(MAX_STRING_SIZE >= HOST_NAME_MAX);
-  SearchRequest searchReq{
-    //! NOTE: its technically neither but as a passive component its interpreted as a topic
-    .type = SearchRequest::TOPIC
-  };
-  gethostname(searchReq.name, HOST_NAME_MAX);
-  LOG_DEBUG("Host name in search request: " << searchReq.name);
+  std::vector<requestId_t> unsubscriptions;
+  {
+    const std::lock_guard<std::mutex> scopedLock(mAttributeSubscriptionMutex);
 
-  requestId_t requestId;
-  mIpcClient.sendSearchRequest(searchReq, requestId);
-  SearchResponse searchResp = mIpcClient.receiveSearchResponse().value();
-  LOG_TRACE("Got member with primaryKey: " << searchResp.primaryKey);
+    for (const MemberPtr &member: members)
+      if (member.valid())
+        this->removeAttributeSources(member.mpMember, unsubscriptions);
+  }
+  this->sendUnsubscribeRequests(unsubscriptions);
+}
 
-  SingleAttributesRequest singleAttributeReq{
-    .attribute = AttributeName::CPU_UTILIZATION,
-    .direction = Direction::NONE,
-    .continuous = true
-  };
-  //! NOTE: I am aware that memcpy is considered insecure in regards to writing on unowned memory
-  //!       but as both buffers are the same size I don't see this exploding into our faces.
-  std::memcpy(singleAttributeReq.primaryKey, searchResp.primaryKey, MAX_STRING_SIZE);
-  mIpcClient.sendSingleAttributesRequest(singleAttributeReq, requestId);
-  SingleAttributesResponse singleAttrResp = mIpcClient.receiveSingleAttributesResponse().value();
-  assert(singleAttrResp.requestID == requestId);
+void DataStore::removeAttributeSources(Member *member, std::vector<requestId_t> &oUnsubscriptions)
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(member));
 
-  return SharedMemory(util::parseString(singleAttrResp.memAddress));
+  if (!member->mAttributesSubscribed)
+    return;
+  member->mAttributesSubscribed = false;
+  ++member->mAttributeGeneration;
+
+  for (const Member::Attribute &attribute: member->takeAttributeSources())
+    oUnsubscriptions.push_back(attribute.requestId);
+  LOG_TRACE("Removed attribute sources of " << member);
 }
 
-void DataStore::addSubUpdate(Nodes::iterator affected, PrimaryKey other)
+void DataStore::sendUnsubscribeRequests(const std::vector<requestId_t> &subscriptions)
 {
-  const ScopeLock scopedLock(mUpdatesMutex);
+  LOG_TRACE(LOG_THIS LOG_VAR(subscriptions.size()));
 
-  GraphView::iterator it = std::find_if(
-    mUpdates.begin(), mUpdates.end(),
-    [&affected](const GraphView::value_type &element) -> bool
-    {
-      return element.member.mPrimaryKey == affected->instance.mPrimaryKey;
-    }
-  );
-  if (it == mUpdates.end())
-    mUpdates.push_back(MemberConnections{
-      .member = MemberProxy(affected->instance.mPrimaryKey, false),
-      .connections = {MemberProxy(other, true),}
-    });
-  else
-    it->connections.push_back(MemberProxy(other, true));
+  //! NOTE: unsubscriptions are not answered, so they can be sent back to back
+  for (requestId_t subscription: subscriptions)
+  {
+    UnsubscribeRequest req{.id = subscription};
+    mIpcReactor.sendUnsubscribeRequest(req);
+  }
 }
 
-void DataStore::addSendUpdate(Nodes::iterator affected, PrimaryKey other)
+void DataStore::addAttributeSources(const std::vector<Member *> &members)
 {
-  const ScopeLock scopedLock(mUpdatesMutex);
+  LOG_TRACE(LOG_THIS LOG_VAR(members.size()));
 
-  GraphView::iterator it = std::find_if(
-    mUpdates.begin(), mUpdates.end(),
-    [&affected](const GraphView::value_type &element) -> bool
-    {
-      return element.member.mPrimaryKey == affected->instance.mPrimaryKey;
-    }
-  );
-  if (it == mUpdates.end())
-    mUpdates.push_back(MemberConnections{
-      .member = MemberProxy(affected->instance.mPrimaryKey, false),
-      .connections = {MemberProxy(other, false),}
-    });
-  else
-    it->connections.push_back(MemberProxy(other, false));
+  for (PendingAttribute &attribute: this->requestAttributeSources(members))
+  {
+    SingleAttributesResponse response = attribute.response.get();
+    LOG_TRACE("Added attribute " << attribute.attribute << " to " << attribute.member << " with shared memory location: " << response.memAddress);
+    attribute.member->addAttributeSource(std::to_string(attribute.attribute), response);
+  }
 }
 
-void DataStore::addPubUpdate(Topics::iterator affected, PrimaryKey other)
+std::vector<DataStore::PendingAttribute> DataStore::requestAttributeSources(const std::vector<Member *> &members, const IpcReactor::ResponseNotifier &notify)
 {
-  const ScopeLock scopedLock(mUpdatesMutex);
+  LOG_TRACE(LOG_THIS LOG_VAR(members.size()));
 
-  GraphView::iterator it = std::find_if(
-    mUpdates.begin(), mUpdates.end(),
-    [&affected](const GraphView::value_type &element) -> bool
+  std::vector<PendingAttribute> output;
+  SingleAttributesRequest req{
+    .attribute = AttributeName::CPU_UTILIZATION,
+    .direction = Direction::NONE,
+    .continuous = true
+  };
+  for (Member *member: members)
+  {
+    util::parseString(req.primaryKey, member->mPrimaryKey.toString());
+    for (AttributeName attribute: (member->mIsTopic ? cmTopicAttributes : cmNodeAttributes))
     {
-      return element.member.mPrimaryKey == affected->instance.mPrimaryKey;
+      req.attribute = attribute;
+      output.push_back(PendingAttribute{
+        .member = member,
+        .attribute = attribute,
+        .generation = member->mAttributeGeneration,
+        .response = mIpcReactor.sendSingleAttributesRequest(req, notify)
+      });
     }
-  );
-  if (it == mUpdates.end())
-    mUpdates.push_back(MemberConnections{
-      .member = MemberProxy(affected->instance.mPrimaryKey, true),
-      .connections = {MemberProxy(other, false),}
-    });
-  else
-    it->connections.push_back(MemberProxy(other, false));
+  }
+  LOG_DEBUG("Sent " << output.size() << " attribute requests for " << members.size() << " members.");
+
+  return output;
 }
 
-DataStore::GraphView DataStore::getUpdates()
+DataStore::GraphView DataStore::getFullGraphView()
 {
-  GraphView output;
-  const ScopeLock scopedLock(mUpdatesMutex);
+  LOG_TRACE(LOG_THIS);
 
-  std::move(mUpdates.begin(), mUpdates.end(), std::back_inserter(output));
-  mUpdates.clear();
+  if (!this->tryBeginTopologySeed(false))
+    return this->getTopologySnapshot();
 
-  return output;
+  return this->seedTopology();
 }
 
-void DataStore::run(const std::atomic<bool> &running, cr::milliseconds loopTargetInterval)
+Task<DataStore::GraphView> DataStore::coGetFullGraphView(Executor &executor)
+{
+  LOG_TRACE(LOG_THIS);
+
+  if (!this->tryBeginTopologySeed(false))
+    co_return this->getTopologySnapshot();
+
+  LOG_DEBUG("(Re-)Seeding topology mirror from full graph query.");
+  Timestamp seedTime = cr::system_clock::now();
+  CustomMemberResponse response = co_await executor.wait(mIpcReactor.sendCustomMemberRequest(cmFullGraphRequest, executor.getNotifier()));
+
+  co_return this->seedTopology(this->parseFullGraphView(response), seedTime);
+}
+
+bool DataStore::tryBeginTopologySeed(bool force)
+{
+  const std::lock_guard<std::mutex> scopedLock(mTopologyMutex);
+
+  //! NOTE: only one seed at a time, everybody else gets the current mirror
+  if (mTopologySeeding)
+    return false;
+  if (!force &&
+      mTopologySeeded &&
+      (cmTopologyRefreshInterval.count() == 0 || cr::system_clock::now() - mTopologySeedTime <= cmTopologyRefreshInterval))
+    return false;
+
+  const std::vector<std::unique_lock<std::mutex>> shardLocks = this->lockTopologyShards();
+  mTopologySeeding = true;
+
+  return true;
+}
+
+DataStore::GraphView DataStore::seedTopology()
+{
+  LOG_TRACE(LOG_THIS);
+
+  LOG_DEBUG("(Re-)Seeding topology mirror from full graph query.");
+  Timestamp seedTime = cr::system_clock::now();
+
+  return this->seedTopology(this->queryFullGraphView(), seedTime);
+}
+
+DataStore::GraphView DataStore::seedTopology(GraphView fullGraph, Timestamp seedTime)
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(fullGraph.size()));
+
+
+  // partitioned the same way as the mirror, so each part can just be swapped in
+  std::hash<PrimaryKey> hasher;
+  std::vector<Topology> topologies(mShards.size());
+  for (const MemberConnections &vertex: fullGraph)
+  {
+    Topology &topology = topologies[hasher(vertex.member.mPrimaryKey) % mShards.size()];
+    TopologyVertex &topologyVertex = topology.try_emplace(vertex.member.mPrimaryKey, TopologyVertex{vertex.member.mIsTopic, {}}).first->second;
+    for (const MemberProxy &connection: vertex.connections)
+    {
+      topologies[hasher(connection.mPrimaryKey) % mShards.size()].try_emplace(connection.mPrimaryKey, TopologyVertex{connection.mIsTopic, {}});
+      if (std::find(topologyVertex.outgoing.begin(), topologyVertex.outgoing.end(), connection) == topologyVertex.outgoing.end())
+        topologyVertex.outgoing.push_back(connection);
+    }
+  }
+
+  {
+    const std::lock_guard<std::mutex> scopedLock(mTopologyMutex);
+    const std::vector<std::unique_lock<std::mutex>> shardLocks = this->lockTopologyShards();
+
+    for (size_t i = 0ul; i < mShards.size(); ++i)
+      mShards[i]->topology = std::move(topologies[i]);
+    // re-apply whatever changed while the query was running
+    for (const std::unique_ptr<MemberShard> &shard: mShards)
+    {
+      for (const auto &[from, to]: shard->backlog)
+        this->applyTopologyEdgeInternal(from, to);
+      shard->backlog.clear();
+    }
+    mTopologySeeding = false;
+    mTopologySeeded = true;
+    mTopologySeedTime = seedTime;
+  }
+
+  return fullGraph;
+}
+
+DataStore::GraphView DataStore::getTopologySnapshot()
+{
+  LOG_TRACE(LOG_THIS);
+
+  const std::vector<std::unique_lock<std::mutex>> shardLocks = this->lockTopologyShards();
+
+  GraphView output;
+  for (const std::unique_ptr<MemberShard> &shard: mShards)
+    for (const auto &[primaryKey, vertex]: shard->topology)
+      output.push_back(MemberConnections{
+        .member = MemberProxy(primaryKey, vertex.isTopic),
+        .connections = vertex.outgoing
+      });
+
+  return output;
+}
+
+std::vector<std::unique_lock<std::mutex>> DataStore::lockTopologyShards()
+{
+  //! NOTE: always locked in the same order, so this can't deadlock with
+  //!       itself; everybody else only ever holds a single shard's mutex
+  std::vector<std::unique_lock<std::mutex>> shardLocks;
+  shardLocks.reserve(mShards.size());
+  for (const std::unique_ptr<MemberShard> &shard: mShards)
+    shardLocks.emplace_back(shard->topologyMutex);
+
+  return shardLocks;
+}
+
+void DataStore::applyTopologyEdge(const MemberProxy &from, const MemberProxy &to)
+{
+  if ((from.mIsTopic && this->checkTopicPrimaryIgnored(from.mPrimaryKey)) ||
+      (to.mIsTopic && this->checkTopicPrimaryIgnored(to.mPrimaryKey)))
+    return;
+
+  LOG_TRACE(LOG_THIS << from << " -> " << to);
+
+  //! NOTE: the edge lives with its source vertex, the target vertex only has
+  //!       to exist; both shards are locked one after another, as a seed
+  //!       replaying the backlog adds the target vertex again anyway
+  {
+    MemberShard &fromShard = this->getShard(from.mPrimaryKey);
+    const std::lock_guard<std::mutex> scopedLock(fromShard.topologyMutex);
+
+    if (mTopologySeeding)
+      fromShard.backlog.emplace_back(from, to);
+    TopologyVertex &fromVertex = fromShard.topology.try_emplace(from.mPrimaryKey, TopologyVertex{from.mIsTopic, {}}).first->second;
+    if (std::find(fromVertex.outgoing.begin(), fromVertex.outgoing.end(), to) == fromVertex.outgoing.end())
+      fromVertex.outgoing.push_back(to);
+  }
+  {
+    MemberShard &toShard = this->getShard(to.mPrimaryKey);
+    const std::lock_guard<std::mutex> scopedLock(toShard.topologyMutex);
+
+    toShard.topology.try_emplace(to.mPrimaryKey, TopologyVertex{to.mIsTopic, {}});
+  }
+}
+
+void DataStore::applyTopologyEdgeInternal(const MemberProxy &from, const MemberProxy &to)
+{
+  LOG_TRACE(LOG_THIS << from << " -> " << to);
+
+  //! NOTE: expects the shards of both vertices to be locked
+  TopologyVertex &fromVertex = this->getShard(from.mPrimaryKey).topology.try_emplace(from.mPrimaryKey, TopologyVertex{from.mIsTopic, {}}).first->second;
+  this->getShard(to.mPrimaryKey).topology.try_emplace(to.mPrimaryKey, TopologyVertex{to.mIsTopic, {}});
+
+  if (std::find(fromVertex.outgoing.begin(), fromVertex.outgoing.end(), to) == fromVertex.outgoing.end())
+    fromVertex.outgoing.push_back(to);
+}
+
+DataStore::GraphView DataStore::queryFullGraphView() const
+{
+  LOG_TRACE(LOG_THIS);
+
+  // send a request for the whole graph structure
+  return this->parseFullGraphView(mIpcReactor.sendCustomMemberRequest(cmFullGraphRequest).get());
+}
+
+DataStore::GraphView DataStore::parseFullGraphView(const CustomMemberResponse &resp) const
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(resp.memAddress));
+
+  // stream the textual responses straight into the parser
+  sharedMem::SHMChannel<sharedMem::Response> channel(resp.memAddress, false);
+  ShmTextStreamBuffer responseBuffer(channel);
+  std::istream responseStream(&responseBuffer);
+  GraphQuerySaxHandler handler;
+  if (!json::json::sax_parse(responseStream, &handler))
+  {
+    LOG_ERROR("Failed to parse full graph query response.");
+    return GraphView();
+  }
+
+  return assembleGraphView(handler, [this](const PrimaryKey &primaryKey) { return this->checkTopicPrimaryIgnored(primaryKey); });
+}
+
+DataStore::SharedMemory DataStore::getCpuUtilisationMemory() const
+{
+  LOG_TRACE(LOG_THIS);
+
+  static_assert(MAX_STRING_SIZE >= HOST_NAME_MAX);
+  SearchRequest searchReq{
+    //! NOTE: its technically neither but as a passive component its interpreted as a topic
+    .type = SearchRequest::TOPIC
+  };
+  gethostname(searchReq.name, HOST_NAME_MAX);
+  LOG_DEBUG("Host name in search request: " << searchReq.name);
+
+  SearchResponse searchResp = mIpcReactor.sendSearchRequest(searchReq).get();
+  LOG_TRACE("Got member with primaryKey: " << searchResp.primaryKey);
+
+  SingleAttributesRequest singleAttributeReq{
+    .attribute = AttributeName::CPU_UTILIZATION,
+    .direction = Direction::NONE,
+    .continuous = true
+  };
+  //! NOTE: I am aware that memcpy is considered insecure in regards to writing on unowned memory
+  //!       but as both buffers are the same size I don't see this exploding into our faces.
+  std::memcpy(singleAttributeReq.primaryKey, searchResp.primaryKey, MAX_STRING_SIZE);
+  SingleAttributesResponse singleAttrResp = mIpcReactor.sendSingleAttributesRequest(singleAttributeReq).get();
+
+  return SharedMemory(util::parseString(singleAttrResp.memAddress));
+}
+
+void DataStore::addSubUpdate(Nodes::iterator affected, PrimaryKey other)
+{
+  this->addUpdate(MemberProxy(affected->instance.mPrimaryKey, false), MemberProxy(other, true));
+}
+
+void DataStore::addSendUpdate(Nodes::iterator affected, PrimaryKey other)
+{
+  this->addUpdate(MemberProxy(affected->instance.mPrimaryKey, false), MemberProxy(other, false));
+}
+
+void DataStore::addPubUpdate(Topics::iterator affected, PrimaryKey other)
+{
+  this->addUpdate(MemberProxy(affected->instance.mPrimaryKey, true), MemberProxy(other, false));
+}
+
+void DataStore::addUpdate(const MemberProxy &affected, const MemberProxy &other)
+{
+  if (mUpdateChannel.push(ConnectionUpdate{
+        .member = affected.mPrimaryKey,
+        .other = other.mPrimaryKey,
+        .memberIsTopic = affected.mIsTopic,
+        .otherIsTopic = other.mIsTopic
+      }))
+    return;
+
+  // the consumer is lagging behind, don't lose the update but take the slow path
+  const std::lock_guard<std::mutex> scopedLock(mUpdatesMutex);
+
+  // try_emplace only constructs the entry if the member has no pending updates yet
+  PendingConnections &pending = mUpdates.try_emplace(
+    affected.mPrimaryKey,
+    PendingConnections{.isTopic = affected.mIsTopic, .connections = {}}
+  ).first->second;
+  pending.connections.insert(other);
+  mUpdatesSpilled.store(true);
+}
+
+DataStore::ConnectionUpdates DataStore::getUpdates()
+{
+  //! NOTE: mUpdatesBack is only ever touched by the (single) consumer calling
+  //!       this, so both paths are merged into it outside of the lock; clearing
+  //!       instead of reassigning it keeps the buckets for the producers after
+  //!       the next swap
+  if (mUpdatesSpilled.exchange(false))
+  {
+    LOG_WARN("Update channel overflowed " << mUpdateChannel.takeOverflowCount() << " times, consider increasing " CONFIG_DATA_STORE "." CONFIG_UPDATE_CHANNEL_CAPACITY ".");
+
+    const std::lock_guard<std::mutex> scopedLock(mUpdatesMutex);
+    std::swap(mUpdates, mUpdatesBack);
+  }
+
+  //! NOTE: bounded by the capacity so that a steady stream of producers can
+  //!       not keep the consumer in here forever
+  ConnectionUpdate update;
+  for (size_t i = 0ul; i < mUpdateChannel.capacity() && mUpdateChannel.pop(update); ++i)
+    mUpdatesBack.try_emplace(
+      update.member,
+      PendingConnections{.isTopic = update.memberIsTopic, .connections = {}}
+    ).first->second.connections.emplace(update.other, update.otherIsTopic);
+
+  ConnectionUpdates output;
+  for (const auto &[primaryKey, pending]: mUpdatesBack)
+    for (const MemberProxy &other: pending.connections)
+      output.push_back(ConnectionUpdate{
+        .member = primaryKey,
+        .other = other.mPrimaryKey,
+        .memberIsTopic = pending.isTopic,
+        .otherIsTopic = other.mIsTopic
+      });
+  mUpdatesBack.clear();
+
+  return output;
+}
+
+void DataStore::run(const std::atomic<bool> &running, cr::milliseconds loopTargetInterval)
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(running.load()))
+
+  std::vector<std::thread> shardWorkers;
+  if (cmShardWorkers)
+  {
+    shardWorkers.reserve(mShards.size());
+    for (const std::unique_ptr<MemberShard> &shard: mShards)
+      shardWorkers.emplace_back(&DataStore::runUpdateShard, this, std::cref(running), std::ref(*shard), loopTargetInterval);
+  }
+  LOG_DEBUG("Started " << shardWorkers.size() << " update shard workers.");
+  std::thread warmStartValidation;
+  if (mpWarmStart)
+    warmStartValidation = std::thread(&DataStore::validateWarmStart, this, std::cref(running));
+
+  if (cmEventDriven)
+    this->runEventDriven(running, loopTargetInterval);
+  else
+    this->runPolling(running, loopTargetInterval);
+
+  for (std::thread &worker: shardWorkers)
+    worker.join();
+  if (warmStartValidation.joinable())
+    warmStartValidation.join();
+
+  if (!cmWarmStartPath.empty())
+    this->writeWarmStart();
+}
+
+void DataStore::runPolling(const std::atomic<bool> &running, cr::milliseconds loopTargetInterval)
 {
   LOG_TRACE(LOG_THIS LOG_VAR(running.load()))
 
@@ -446,184 +1124,614 @@ void DataStore::run(const std::atomic<bool> &running, cr::milliseconds loopTarge
   {
     start = cr::system_clock::now();
 
-    for (Nodes::iterator it = mNodes.begin(); it != mNodes.end();)
-    {
-      if (it->useCounter.nonZero())
-      {
-        ++it;
-        continue;
-      }
-
-      LOG_TRACE("Removing " << it->instance << "from data store");
-      UnsubscribeRequest req{.id = it->requestId};
-      requestId_t unsubReqId;
+    this->collectUpdateSubscriptions();
+    this->evictUnused();
+    this->writeWarmStartIfDue(start);
 
-      const ScopeLock scopedLock(mNodesMutex);
-      mIpcClient.sendUnsubscribeRequest(req, unsubReqId);
-      it = mNodes.erase(it);
-    }
-    for (Topics::iterator it = mTopics.begin(); it != mTopics.end();)
+    size_t nrReceived = this->receiveUpdates(running);
+    if (cmDrainUpdates)
     {
-      if (it->useCounter.nonZero())
+      // keep going as long as there are updates left, but don't starve the eviction
+      Timestamp drainDeadline = start + cmDrainBudget;
+      size_t nrReceivedNow = nrReceived;
+      while (nrReceivedNow > 0ul && running.load() && cr::system_clock::now() < drainDeadline)
       {
-        ++it;
-        continue;
+        nrReceivedNow = this->receiveUpdates(running);
+        nrReceived += nrReceivedNow;
       }
+    }
+    if (nrReceived > 0ul)
+      LOG_DEBUG("Received " << nrReceived << " updates, " << mBacklogDepth.load() << " of which are not applied yet.");
 
-      LOG_TRACE("Removing " << it->instance << "from data store");
-      UnsubscribeRequest req{.id = it->requestId};
-      requestId_t unsubReqId;
+    stop = cr::system_clock::now();
+    cr::milliseconds remainingTime = loopTargetInterval - cr::duration_cast<cr::milliseconds>(stop - start);
+    if (remainingTime.count() > 0)
+      std::this_thread::sleep_for(remainingTime);
+  }
+}
 
-      const ScopeLock scopedLock(mTopicsMutex);
-      mIpcClient.sendUnsubscribeRequest(req, unsubReqId);
-      it = mTopics.erase(it);
-    }
+void DataStore::runEventDriven(const std::atomic<bool> &running, cr::milliseconds loopTargetInterval)
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(running.load()))
 
-    std::optional<NodePublishersToUpdate> publishersToUpdate = mIpcClient.receiveNodePublishersToUpdate(false);
-    if (publishersToUpdate.has_value())
-    {
-      NodePublishersToUpdate publishersToUpdateValue = publishersToUpdate.value();
-      PrimaryKey primaryKey = util::parseString(publishersToUpdateValue.primaryKey);
-      LOG_TRACE("Got NodePublishersToUpdate for " LOG_VAR(primaryKey));
-
-      const ScopeLock scopedLock(mNodesMutex);
-      Nodes::iterator it = mNodes.find(primaryKey);
-      if (it != mNodes.end())
-        it->instance.update(publishersToUpdateValue);
-      else
-        LOG_ERROR("No node with " LOG_VAR(primaryKey) " in data store, ignoring update");
-    }
-    std::optional<NodeSubscribersToUpdate> subscribersToUpdate = mIpcClient.receiveNodeSubscribersToUpdate(false);
-    if (subscribersToUpdate.has_value())
-    {
-      NodeSubscribersToUpdate subscribersToUpdateValue = subscribersToUpdate.value();
-      PrimaryKey primaryKey = util::parseString(subscribersToUpdateValue.primaryKey);
-      LOG_TRACE("Got NodeSubscribersToUpdate for " LOG_VAR(primaryKey));
+  //! NOTE: the reactor polls for updates on a thread of its own, which hands
+  //!       them over to this one
+  mIpcReactor.startUpdateReceiver([this, &running](const MemberUpdate &update) { this->handOverUpdate(running, update); });
 
-      const ScopeLock scopedLock(mNodesMutex);
-      Nodes::iterator it = mNodes.find(primaryKey);
-      if (it != mNodes.end())
-      {
-        it->instance.update(subscribersToUpdateValue);
-        this->addSubUpdate(it, util::parseString(subscribersToUpdateValue.subscribesTo));
-      }
-      else
-        LOG_ERROR("No node with " LOG_VAR(primaryKey) " in data store, ignoring update");
-    }
-    std::optional<NodeIsServerForUpdate> isServerForUpdate = mIpcClient.receiveNodeIsServerForUpdate(false);
-    if (isServerForUpdate.has_value())
+  MemberUpdate update;
+  Timestamp now, nextCycle = cr::system_clock::now();
+  while (running.load())
+  {
+    now = cr::system_clock::now();
+    if (now >= nextCycle)
     {
-      NodeIsServerForUpdate isServerForUpdateValue = isServerForUpdate.value();
-      PrimaryKey primaryKey = util::parseString(isServerForUpdateValue.primaryKey);
-      LOG_TRACE("Got NodeIsServerForUpdate for " LOG_VAR(primaryKey));
-
-      const ScopeLock scopedLock(mNodesMutex);
-      Nodes::iterator it = mNodes.find(primaryKey);
-      if (it != mNodes.end())
-        it->instance.update(isServerForUpdateValue);
-      else
-        LOG_ERROR("No node with " LOG_VAR(primaryKey) " in data store, ignoring update");
+      this->collectUpdateSubscriptions();
+      this->evictUnused();
+      this->writeWarmStartIfDue(now);
+      nextCycle = now + loopTargetInterval;
     }
-    std::optional<NodeIsClientOfUpdate> isClientOfUpdate = mIpcClient.receiveNodeIsClientOfUpdate(false);
-    if (isClientOfUpdate.has_value())
-    {
-      NodeIsClientOfUpdate isClientOfUpdateValue = isClientOfUpdate.value();
-      PrimaryKey primaryKey = util::parseString(isClientOfUpdateValue.primaryKey);
-      LOG_TRACE("Got NodeIsClientOfUpdate for " LOG_VAR(primaryKey));
 
-      const ScopeLock scopedLock(mNodesMutex);
-      Nodes::iterator it = mNodes.find(primaryKey);
-      if (it != mNodes.end())
-      {
-        it->instance.update(isClientOfUpdateValue);
-        this->addSendUpdate(it, util::parseString(isClientOfUpdateValue.serverNodeId));
-      }
-      else
-        LOG_ERROR("No node with " LOG_VAR(primaryKey) " in data store, ignoring update");
-    }
-    std::optional<NodeIsActionServerForUpdate> isActionServerForUpdate = mIpcClient.receiveNodeIsActionServerForUpdate(false);
-    if (isActionServerForUpdate.has_value())
+    if (!mReceivedUpdates.waitUntil(nextCycle))
+      continue;
+
+    while (mReceivedUpdates.pop(update))
+      this->dispatchUpdate(running, update);
+
+    const std::lock_guard<std::mutex> scopedLock(mReceivedSpaceMutex);
+    if (mNrBlockedReaders > 0ul)
+      mReceivedSpaceCondition.notify_all();
+  }
+
+  {
+    const std::lock_guard<std::mutex> scopedLock(mReceivedSpaceMutex);
+    mReceivedSpaceCondition.notify_all();
+  }
+  mIpcReactor.stopUpdateReceiver();
+}
+
+void DataStore::handOverUpdate(const std::atomic<bool> &running, const MemberUpdate &update)
+{
+  //! NOTE: counted before it can be applied, so the count never drops below zero
+  mBacklogDepth.fetch_add(1ul, std::memory_order_relaxed);
+  if (mReceivedUpdates.push(update))
+    return;
+
+  //! NOTE: a full queue throttles the receiving, the messages wait in the
+  //!       IPC queue; the run thread wakes the blocked readers after draining
+  std::unique_lock<std::mutex> scopedLock(mReceivedSpaceMutex);
+  ++mNrBlockedReaders;
+  bool pushed;
+  while (!(pushed = mReceivedUpdates.push(update)) && running.load())
+    mReceivedSpaceCondition.wait(scopedLock);
+  --mNrBlockedReaders;
+  if (!pushed)
+    mBacklogDepth.fetch_sub(1ul, std::memory_order_relaxed);
+}
+
+void DataStore::enqueueRelease(const PrimaryKey &primaryKey, bool isTopic)
+{
+  //! NOTE: called from whichever thread drops the last MemberPtr, so this
+  //!       must not block; if the queue is full the next eviction falls back
+  //!       to scanning all members
+  if (!mReleaseQueue.push(ReleasedMember{.primaryKey = primaryKey, .isTopic = isTopic}))
+    mReleaseQueueOverflowed.store(true);
+}
+
+void DataStore::evictUnused()
+{
+  LOG_TRACE(LOG_THIS);
+
+  const Timestamp now = cr::system_clock::now();
+  const Timestamp::rep nowRep = now.time_since_epoch().count();
+
+  // members which lost their last user since the last call go into retention
+  ReleasedMember released;
+  for (size_t i = 0ul; i < mReleaseQueue.capacity() && mReleaseQueue.pop(released); ++i)
+  {
+    MemberShard &shard = this->getShard(released.primaryKey);
+    if (released.isTopic)
     {
-      NodeIsActionServerForUpdate isActionServerForUpdateValue = isActionServerForUpdate.value();
-      PrimaryKey primaryKey = util::parseString(isActionServerForUpdateValue.primaryKey);
-      LOG_TRACE("Got NodeIsActionServerForUpdate for " LOG_VAR(primaryKey));
-
-      const ScopeLock scopedLock(mNodesMutex);
-      Nodes::iterator it = mNodes.find(primaryKey);
-      if (it != mNodes.end())
-        it->instance.update(isActionServerForUpdateValue);
-      else
-        LOG_ERROR("No node with " LOG_VAR(primaryKey) " in data store, ignoring update");
+      const Topics::Snapshot topics = shard.topics.snapshot();
+      Topics::iterator it = topics.find(released.primaryKey);
+      if (it)
+        this->retainIfUnused(it, true, nowRep);
     }
-    std::optional<NodeIsActionClientOfUpdate> isActionClientOfUpdate = mIpcClient.receiveNodeIsActionClientOfUpdate(false);
-    if (isActionClientOfUpdate.has_value())
+    else
     {
-      NodeIsActionClientOfUpdate isActionClientOfUpdateValue = isActionClientOfUpdate.value();
-      PrimaryKey primaryKey = util::parseString(isActionClientOfUpdateValue.primaryKey);
-      LOG_TRACE("Got NodeIsActionClientOfUpdate for " LOG_VAR(primaryKey));
-
-      const ScopeLock scopedLock(mNodesMutex);
-      Nodes::iterator it = mNodes.find(primaryKey);
-      if (it != mNodes.end())
-      {
-        it->instance.update(isActionClientOfUpdateValue);
-        this->addSendUpdate(it, util::parseString(isActionClientOfUpdateValue.actionserverNodeId));
-      }
-      else
-        LOG_ERROR("No node with " LOG_VAR(primaryKey) " in data store, ignoring update");
+      const Nodes::Snapshot nodes = shard.nodes.snapshot();
+      Nodes::iterator it = nodes.find(released.primaryKey);
+      if (it)
+        this->retainIfUnused(it, false, nowRep);
     }
-    //! NOTE: NodeTimerToUpdate not currently regarded
-    std::optional<NodeStateUpdate> stateUpdate = mIpcClient.receiveNodeStateUpdate(false);
-    if (stateUpdate.has_value())
+  }
+  if (mReleaseQueueOverflowed.exchange(false))
+  {
+    LOG_WARN("Release queue overflowed " << mReleaseQueue.takeOverflowCount() << " times, consider increasing " CONFIG_DATA_STORE "." CONFIG_RELEASE_QUEUE_CAPACITY ".");
+    for (const std::unique_ptr<MemberShard> &shard: mShards)
     {
-      NodeStateUpdate stateUpdateValue = stateUpdate.value();
-      PrimaryKey primaryKey = util::parseString(stateUpdateValue.primaryKey);
-      LOG_TRACE("Got NodeStateUpdate for " LOG_VAR(primaryKey));
-
-      const ScopeLock scopedLock(mNodesMutex);
-      Nodes::iterator it = mNodes.find(primaryKey);
-      if (it != mNodes.end())
-        it->instance.update(stateUpdateValue);
-      else
-        LOG_ERROR("No node with " LOG_VAR(primaryKey) " in data store, ignoring update");
+      shard->nodes.snapshot().forEach([this, nowRep](Nodes::iterator it) { this->retainIfUnused(it, false, nowRep); });
+      shard->topics.snapshot().forEach([this, nowRep](Topics::iterator it) { this->retainIfUnused(it, true, nowRep); });
     }
-    std::optional<TopicPublishersUpdate> publishersUpdate = mIpcClient.receiveTopicPublishersUpdate(false);
-    if (publishersUpdate.has_value())
-    {
-      TopicPublishersUpdate publishersUpdateValue = publishersUpdate.value();
-      PrimaryKey primaryKey = util::parseString(publishersUpdateValue.primaryKey);
-      LOG_TRACE("Got TopicPublishersUpdate for " LOG_VAR(primaryKey));
+  }
 
-      const ScopeLock scopedLock(mTopicsMutex);
-      Topics::iterator it = mTopics.find(primaryKey);
-      if (it != mTopics.end())
-      {
-        it->instance.update(publishersUpdateValue);
-        this->addPubUpdate(it, util::parseString(publishersUpdateValue.publisher));
-      }
-      else
-        LOG_ERROR("No topic with " LOG_VAR(primaryKey) " in data store, ignoring update");
-    }
-    std::optional<TopicSubscribersUpdate> subscribersUpdate = mIpcClient.receiveTopicSubscribersUpdate(false);
-    if (subscribersUpdate.has_value())
+  // evict the ones whose grace period is over, or the oldest ones if there are too many
+  std::vector<requestId_t> unsubscriptions;
+  size_t nrRemoved = 0ul;
+  while (!mRetained.empty())
+  {
+    const RetainedMember &oldest = mRetained.front();
+    if (now - Timestamp(Timestamp::duration(oldest.releasedAt)) < cmRetentionGracePeriod &&
+        mNrRetained.load() <= cmRetentionCapacity)
+      break;
+
+    if (oldest.isTopic ?
+          this->evictRetained<Topics>(oldest, unsubscriptions) :
+          this->evictRetained<Nodes>(oldest, unsubscriptions))
+      ++nrRemoved;
+    mRetained.pop_front();
+  }
+  //! NOTE: members erased while a snapshot was alive are only destroyed
+  //!       later on, which should happen here as well, not on a reader
+  for (const std::unique_ptr<MemberShard> &shard: mShards)
+  {
+    shard->nodes.reclaim();
+    shard->topics.reclaim();
+  }
+  if (nrRemoved == 0ul)
+    return;
+
+  this->sendUnsubscribeRequests(unsubscriptions);
+  LOG_DEBUG("Removed " << nrRemoved << " members. Node pool: " << this->getPoolStatistics<Nodes>() << ", topic pool: " << this->getPoolStatistics<Topics>() << ", retention: " << this->getRetentionStatistics());
+}
+
+template<typename List>
+typename List::PoolStatistics DataStore::getPoolStatistics() const
+{
+  //! NOTE: the high water marks of the shards were not necessarily reached
+  //!       at the same time, so their sum is an upper bound
+  typename List::PoolStatistics output{.live = 0ul, .slabs = 0ul, .highWaterMark = 0ul};
+  for (const std::unique_ptr<MemberShard> &shard: mShards)
+  {
+    const typename List::PoolStatistics statistics = shard->getList<List>().getPoolStatistics();
+    output.live += statistics.live;
+    output.slabs += statistics.slabs;
+    output.highWaterMark += statistics.highWaterMark;
+  }
+
+  return output;
+}
+
+DataStore::RetentionStatistics DataStore::getRetentionStatistics() const
+{
+  return RetentionStatistics{
+    .retained = mNrRetained.load(),
+    .hits = mRetentionHits.load(),
+    .misses = mRetentionMisses.load()
+  };
+}
+
+DataStore::IgnoredTopics DataStore::searchIgnoredTopics(const std::atomic<bool> &running)
+{
+  LOG_TRACE(LOG_THIS);
+
+  IgnoredTopics output;
+  SearchRequest rosoutReq{
+    .type = SearchRequest::TOPIC
+  };
+  SearchRequest parameterEventsReq{
+    .type = SearchRequest::TOPIC
+  };
+  util::parseString(rosoutReq.name, "/rosout");
+  util::parseString(parameterEventsReq.name, "/parameter_events");
+
+  //! NOTE: both topics are created together with the first node, so until
+  //!       then there is nothing to find
+  while (running.load())
+  {
     {
-      TopicSubscribersUpdate subscribersUpdateValue = subscribersUpdate.value();
-      PrimaryKey primaryKey = util::parseString(subscribersUpdateValue.primaryKey);
-      LOG_TRACE("Got TopicSubscribersUpdate for " LOG_VAR(primaryKey));
-
-      const ScopeLock scopedLock(mTopicsMutex);
-      Topics::iterator it = mTopics.find(primaryKey);
-      if (it != mTopics.end())
-        it->instance.update(subscribersUpdateValue);
-      else
-        LOG_ERROR("No topic with " LOG_VAR(primaryKey) " in data store, ignoring update");
+      // both searches are in flight at the same time
+      std::optional<std::future<SearchResponse>> rosoutResp, parameterEventsResp;
+      if (output.rosout.empty())
+        rosoutResp = mIpcReactor.sendSearchRequest(rosoutReq);
+      if (output.parameterEvents.empty())
+        parameterEventsResp = mIpcReactor.sendSearchRequest(parameterEventsReq);
+
+      if (rosoutResp.has_value())
+        output.rosout = PrimaryKey(rosoutResp->get().primaryKey);
+      if (parameterEventsResp.has_value())
+        output.parameterEvents = PrimaryKey(parameterEventsResp->get().primaryKey);
     }
+    if (!output.rosout.empty() && !output.parameterEvents.empty())
+      break;
 
-    stop = cr::system_clock::now();
-    cr::milliseconds remainingTime = loopTargetInterval - cr::duration_cast<cr::milliseconds>(stop - start);
-    if (remainingTime.count() > 0)
-      std::this_thread::sleep_for(remainingTime);
+    std::this_thread::sleep_for(cr::milliseconds(100));
+  }
+
+  return output;
+}
+
+void DataStore::loadWarmStart()
+{
+  LOG_TRACE(LOG_THIS);
+
+  mIgnoredTopics[0] = IgnoredTopics{
+    .rosout = mpWarmStart->getRosoutKey(),
+    .parameterEvents = mpWarmStart->getParameterEventsKey()
+  };
+
+  //! NOTE: nothing else runs yet, so the shards don't need to be locked
+  for (const WarmStartFile::VertexRecord &vertex: mpWarmStart->getVertices())
+    this->getShard(vertex.primaryKey).topology.try_emplace(vertex.primaryKey, TopologyVertex{static_cast<bool>(vertex.isTopic), {}});
+  for (const WarmStartFile::EdgeRecord &edge: mpWarmStart->getEdges())
+    this->applyTopologyEdgeInternal(MemberProxy(edge.from, static_cast<bool>(edge.fromIsTopic)), MemberProxy(edge.to, static_cast<bool>(edge.toIsTopic)));
+  //! NOTE: counts as seeded right now, the validation re-seeds it anyway
+  mTopologySeeded = true;
+  mTopologySeedTime = cr::system_clock::now();
+
+  LOG_INFO(
+    "Warm starting from snapshot written " << cr::duration_cast<cr::seconds>(cr::system_clock::now() - mpWarmStart->getWrittenAt()).count() << "s ago with " <<
+    mpWarmStart->getMembers().size() << " members and " << mpWarmStart->getVertices().size() << " topology vertices."
+  );
+}
+
+void DataStore::validateWarmStart(const std::atomic<bool> &running)
+{
+  LOG_TRACE(LOG_THIS);
+
+  const Timestamp start = cr::system_clock::now();
+
+  // if the ignored topics changed, the snapshot stems from another graph
+  const IgnoredTopics ignored = this->searchIgnoredTopics(running);
+  if (!running.load())
+    return;
+  const bool sameGraph = (ignored.rosout == mIgnoredTopics[0].rosout && ignored.parameterEvents == mIgnoredTopics[0].parameterEvents);
+  if (!sameGraph)
+  {
+    LOG_WARN("Warm start snapshot " << cmWarmStartPath << " is outdated, discarding it.");
+    mWarmStartDiscarded.store(true);
+    mIgnoredTopics[1] = ignored;
+    mpIgnoredTopics.store(&mIgnoredTopics[1], std::memory_order_release);
+  }
+
+  if (this->tryBeginTopologySeed(true))
+    this->seedTopology();
+
+  //! NOTE: the members aren't resolved up front, that would subscribe to
+  //!       and unsubscribe from every one of them; the name lookups check
+  //!       the key taken from the snapshot the first time it is used instead
+  LOG_INFO("Validated warm start snapshot in " << cr::duration_cast<cr::milliseconds>(cr::system_clock::now() - start).count() << "ms.");
+}
+
+void DataStore::writeWarmStart()
+{
+  LOG_TRACE(LOG_THIS);
+
+  const IgnoredTopics *ignored = mpIgnoredTopics.load(std::memory_order_acquire);
+  WarmStartFile::Contents contents{
+    .rosoutKey = ignored->rosout,
+    .parameterEventsKey = ignored->parameterEvents,
+    .members = {},
+    .vertices = {},
+    .edges = {}
+  };
+
+  for (const std::unique_ptr<MemberShard> &shard: mShards)
+  {
+    shard->nodes.snapshot().forEach([&contents](Nodes::iterator it) {
+      WarmStartFile::MemberRecord &record = contents.members.emplace_back(WarmStartFile::MemberRecord{.primaryKey = it->instance.mPrimaryKey, .isTopic = false, .name = {}});
+      util::parseString(record.name, it->instance.mName);
+    });
+    shard->topics.snapshot().forEach([&contents](Topics::iterator it) {
+      WarmStartFile::MemberRecord &record = contents.members.emplace_back(WarmStartFile::MemberRecord{.primaryKey = it->instance.mPrimaryKey, .isTopic = true, .name = {}});
+      util::parseString(record.name, it->instance.mName);
+    });
+  }
+
+  for (const MemberConnections &vertex: this->getTopologySnapshot())
+  {
+    contents.vertices.push_back(WarmStartFile::VertexRecord{.primaryKey = vertex.member.mPrimaryKey, .isTopic = vertex.member.mIsTopic});
+    for (const MemberProxy &connection: vertex.connections)
+      contents.edges.push_back(WarmStartFile::EdgeRecord{
+        .from = vertex.member.mPrimaryKey,
+        .to = connection.mPrimaryKey,
+        .fromIsTopic = vertex.member.mIsTopic,
+        .toIsTopic = connection.mIsTopic
+      });
+  }
+
+  if (WarmStartFile::write(cmWarmStartPath, contents))
+    LOG_DEBUG("Wrote warm start snapshot with " << contents.members.size() << " members and " << contents.vertices.size() << " topology vertices.");
+}
+
+void DataStore::writeWarmStartIfDue(Timestamp now)
+{
+  if (cmWarmStartPath.empty() || cmWarmStartInterval.count() == 0 || now - mWarmStartWrittenAt < cmWarmStartInterval)
+    return;
+
+  this->writeWarmStart();
+  mWarmStartWrittenAt = now;
+}
+
+size_t DataStore::receiveUpdates(const std::atomic<bool> &running)
+{
+  LOG_TRACE(LOG_THIS);
+
+  return mIpcReactor.receiveUpdates([this, &running](const MemberUpdate &update)
+  {
+    mBacklogDepth.fetch_add(1ul, std::memory_order_relaxed);
+    this->dispatchUpdate(running, update);
+  });
+}
+
+void DataStore::dispatchUpdate(const std::atomic<bool> &running, const MemberUpdate &update)
+{
+  if (!cmShardWorkers)
+  {
+    this->applyMemberUpdate(update);
+    return;
+  }
+
+  const PrimaryKey primaryKey = std::visit([](const auto &value) { return PrimaryKey(value.primaryKey); }, update);
+  MemberShard &shard = this->getShard(primaryKey);
+  if (shard.updates.push(update))
+    return;
+
+  //! NOTE: a full shard throttles the receiving, just like applying the
+  //!       updates right here would; the messages wait in the IPC queue and
+  //!       the shard's worker wakes the dispatcher after draining
+  std::unique_lock<std::mutex> scopedLock(shard.spaceMutex);
+  ++shard.nrBlockedDispatchers;
+  bool pushed;
+  while (!(pushed = shard.updates.push(update)) && running.load())
+    shard.spaceCondition.wait(scopedLock);
+  --shard.nrBlockedDispatchers;
+  if (!pushed)
+    mBacklogDepth.fetch_sub(1ul, std::memory_order_relaxed);
+}
+
+void DataStore::applyMemberUpdate(const MemberUpdate &update)
+{
+  std::visit([this](const auto &value) { this->applyUpdate(value); }, update);
+  mBacklogDepth.fetch_sub(1ul, std::memory_order_relaxed);
+}
+
+void DataStore::runUpdateShard(const std::atomic<bool> &running, MemberShard &shard, cr::milliseconds loopTargetInterval)
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(&shard));
+
+  MemberUpdate update;
+  while (running.load())
+  {
+    if (!shard.updates.waitUntil(cr::system_clock::now() + loopTargetInterval))
+      continue;
+
+    while (shard.updates.pop(update))
+      this->applyMemberUpdate(update);
+
+    const std::lock_guard<std::mutex> scopedLock(shard.spaceMutex);
+    if (shard.nrBlockedDispatchers > 0ul)
+      shard.spaceCondition.notify_all();
+  }
+
+  // the dispatcher might still wait for space, which will never come now
+  const std::lock_guard<std::mutex> scopedLock(shard.spaceMutex);
+  shard.spaceCondition.notify_all();
+}
+
+void DataStore::applyUpdate(const NodePublishersToUpdate &update)
+{
+  PrimaryKey primaryKey(update.primaryKey);
+  LOG_TRACE("Got NodePublishersToUpdate for " LOG_VAR(primaryKey));
+
+  this->applyTopologyEdge(MemberProxy(primaryKey, false), MemberProxy(update.publishesTo, true));
+
+  const Nodes::Snapshot nodes = this->getShard(primaryKey).nodes.snapshot();
+  Nodes::iterator it = nodes.find(primaryKey);
+  if (it != nodes.end())
+    it->instance.update(update);
+  else
+    LOG_ERROR("No node with " LOG_VAR(primaryKey) " in data store, ignoring update");
+}
+
+void DataStore::applyUpdate(const NodeSubscribersToUpdate &update)
+{
+  PrimaryKey primaryKey(update.primaryKey);
+  LOG_TRACE("Got NodeSubscribersToUpdate for " LOG_VAR(primaryKey));
+
+  this->applyTopologyEdge(MemberProxy(update.subscribesTo, true), MemberProxy(primaryKey, false));
+
+  const Nodes::Snapshot nodes = this->getShard(primaryKey).nodes.snapshot();
+  Nodes::iterator it = nodes.find(primaryKey);
+  if (it != nodes.end())
+  {
+    it->instance.update(update);
+    this->addSubUpdate(it, PrimaryKey(update.subscribesTo));
+  }
+  else
+    LOG_ERROR("No node with " LOG_VAR(primaryKey) " in data store, ignoring update");
+}
+
+void DataStore::applyUpdate(const NodeIsServerForUpdate &update)
+{
+  PrimaryKey primaryKey(update.primaryKey);
+  LOG_TRACE("Got NodeIsServerForUpdate for " LOG_VAR(primaryKey));
+
+  this->applyTopologyEdge(MemberProxy(update.clientNodeId, false), MemberProxy(primaryKey, false));
+
+  const Nodes::Snapshot nodes = this->getShard(primaryKey).nodes.snapshot();
+  Nodes::iterator it = nodes.find(primaryKey);
+  if (it != nodes.end())
+    it->instance.update(update);
+  else
+    LOG_ERROR("No node with " LOG_VAR(primaryKey) " in data store, ignoring update");
+}
+
+void DataStore::applyUpdate(const NodeIsClientOfUpdate &update)
+{
+  PrimaryKey primaryKey(update.primaryKey);
+  LOG_TRACE("Got NodeIsClientOfUpdate for " LOG_VAR(primaryKey));
+
+  this->applyTopologyEdge(MemberProxy(primaryKey, false), MemberProxy(update.serverNodeId, false));
+
+  const Nodes::Snapshot nodes = this->getShard(primaryKey).nodes.snapshot();
+  Nodes::iterator it = nodes.find(primaryKey);
+  if (it != nodes.end())
+  {
+    it->instance.update(update);
+    this->addSendUpdate(it, PrimaryKey(update.serverNodeId));
+  }
+  else
+    LOG_ERROR("No node with " LOG_VAR(primaryKey) " in data store, ignoring update");
+}
+
+void DataStore::applyUpdate(const NodeIsActionServerForUpdate &update)
+{
+  PrimaryKey primaryKey(update.primaryKey);
+  LOG_TRACE("Got NodeIsActionServerForUpdate for " LOG_VAR(primaryKey));
+
+  this->applyTopologyEdge(MemberProxy(update.actionclientNodeId, false), MemberProxy(primaryKey, false));
+
+  const Nodes::Snapshot nodes = this->getShard(primaryKey).nodes.snapshot();
+  Nodes::iterator it = nodes.find(primaryKey);
+  if (it != nodes.end())
+    it->instance.update(update);
+  else
+    LOG_ERROR("No node with " LOG_VAR(primaryKey) " in data store, ignoring update");
+}
+
+void DataStore::applyUpdate(const NodeIsActionClientOfUpdate &update)
+{
+  PrimaryKey primaryKey(update.primaryKey);
+  LOG_TRACE("Got NodeIsActionClientOfUpdate for " LOG_VAR(primaryKey));
+
+  this->applyTopologyEdge(MemberProxy(primaryKey, false), MemberProxy(update.actionserverNodeId, false));
+
+  const Nodes::Snapshot nodes = this->getShard(primaryKey).nodes.snapshot();
+  Nodes::iterator it = nodes.find(primaryKey);
+  if (it != nodes.end())
+  {
+    it->instance.update(update);
+    this->addSendUpdate(it, PrimaryKey(update.actionserverNodeId));
+  }
+  else
+    LOG_ERROR("No node with " LOG_VAR(primaryKey) " in data store, ignoring update");
+}
+
+void DataStore::applyUpdate(const NodeStateUpdate &update)
+{
+  PrimaryKey primaryKey(update.primaryKey);
+  LOG_TRACE("Got NodeStateUpdate for " LOG_VAR(primaryKey));
+
+  const Nodes::Snapshot nodes = this->getShard(primaryKey).nodes.snapshot();
+  Nodes::iterator it = nodes.find(primaryKey);
+  if (it != nodes.end())
+    it->instance.update(update);
+  else
+    LOG_ERROR("No node with " LOG_VAR(primaryKey) " in data store, ignoring update");
+}
+
+void DataStore::applyUpdate(const TopicPublishersUpdate &update)
+{
+  PrimaryKey primaryKey(update.primaryKey);
+  LOG_TRACE("Got TopicPublishersUpdate for " LOG_VAR(primaryKey));
+
+  this->applyTopologyEdge(MemberProxy(update.publisher, false), MemberProxy(primaryKey, true));
+
+  const Topics::Snapshot topics = this->getShard(primaryKey).topics.snapshot();
+  Topics::iterator it = topics.find(primaryKey);
+  if (it != topics.end())
+  {
+    it->instance.update(update);
+    this->addPubUpdate(it, PrimaryKey(update.publisher));
+  }
+  else
+    LOG_ERROR("No topic with " LOG_VAR(primaryKey) " in data store, ignoring update");
+}
+
+void DataStore::applyUpdate(const TopicSubscribersUpdate &update)
+{
+  PrimaryKey primaryKey(update.primaryKey);
+  LOG_TRACE("Got TopicSubscribersUpdate for " LOG_VAR(primaryKey));
+
+  this->applyTopologyEdge(MemberProxy(primaryKey, true), MemberProxy(update.subscriber, false));
+
+  const Topics::Snapshot topics = this->getShard(primaryKey).topics.snapshot();
+  Topics::iterator it = topics.find(primaryKey);
+  if (it != topics.end())
+    it->instance.update(update);
+  else
+    LOG_ERROR("No topic with " LOG_VAR(primaryKey) " in data store, ignoring update");
+}
+
+DataStore::AttributeNames DataStore::parseAttributeNames(const json::json &config)
+{
+  //! NOTE: the fault detection relies on every watched member having at
+  //!       least one attribute
+  if (!config.is_array() || config.empty())
+  {
+    LOG_FATAL("Attribute list has to be a non-empty array of attribute numbers: " << config);
+    std::exit(1);
   }
+
+  AttributeNames output;
+  output.reserve(config.size());
+  for (const json::json &attribute: config)
+    output.push_back(static_cast<AttributeName>(attribute.get<int>()));
+  std::sort(output.begin(), output.end());
+  output.erase(std::unique(output.begin(), output.end()), output.end());
+
+  return output;
+}
+
+NodeResponse DataStore::makeNodeResponse(const PrimaryKey &primary, const json::json &properties)
+{
+  LOG_TRACE(LOG_VAR(primary) LOG_VAR(properties));
+
+  //! NOTE: the graph does not know the package name, it stays empty
+  NodeResponse output{};
+  output.requestID = cNoSubscription;
+  util::parseString(output.primaryKey, primary.toString());
+  util::parseString(output.name, properties.value("name", std::string()));
+  output.state = static_cast<sharedMem::State>(properties.value("state", 0));
+  output.stateChangeTime = properties.value("stateChangeTime", std::time_t(0));
+  output.bootCount = properties.value("bootcounter", 0u);
+  output.pid = properties.value("pid", 0);
+
+  return output;
+}
+
+TopicResponse DataStore::makeTopicResponse(const PrimaryKey &primary, const json::json &properties)
+{
+  LOG_TRACE(LOG_VAR(primary) LOG_VAR(properties));
+
+  //! NOTE: the graph does not know the message type, it stays empty
+  TopicResponse output{};
+  output.requestID = cNoSubscription;
+  util::parseString(output.primaryKey, primary.toString());
+  util::parseString(output.name, properties.value("name", std::string()));
+
+  return output;
+}
+
+CustomMemberRequest DataStore::makeFullGraphRequest(const std::string &query)
+{
+  LOG_TRACE(LOG_VAR(query));
+
+  CustomMemberRequest req{
+    .query = {},
+    .continuous = false
+  };
+  if (query == FULL_GRAPH_QUERY_FULL)
+    setQuery(cFullGraphQuery, req);
+  else if (query == FULL_GRAPH_QUERY_PROJECTION)
+    setQuery(cFullGraphProjectionQuery, req);
+  else if (!packQuery(query, req))
+  {
+    LOG_FATAL("Invalid full graph query configured: " << query);
+    std::exit(1);
+  }
+
+  return req;
 }
 
 IpcClient DataStore::tryMakeIpcClient(const json::json &config)
@@ -675,8 +1783,9 @@ constexpr bool DataStore::checkTopicNameIgnored(const std::string &memberName)
 
 bool DataStore::checkTopicPrimaryIgnored(const PrimaryKey &member) const
 {
+  const IgnoredTopics *ignored = mpIgnoredTopics.load(std::memory_order_acquire);
   return (
-    member == mTopicParameterEventsKey ||
-    member == mTopicRosoutKey
+    member == ignored->parameterEvents ||
+    member == ignored->rosout
   );
 }
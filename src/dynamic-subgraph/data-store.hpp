@@ -3,6 +3,10 @@
 #include "dynamic-subgraph/members.hpp"
 #include "dynamic-subgraph/atomic-counter.hpp"
 #include "dynamic-subgraph/double-linked-list.hpp"
+#include "dynamic-subgraph/mpsc-queue.hpp"
+#include "dynamic-subgraph/warm-start.hpp"
+#include "dynamic-subgraph/ipc-reactor.hpp"
+#include "dynamic-subgraph/task.hpp"
 
 #include "ipc/common.hpp"
 #include "ipc/datastructs/information-datastructs.hpp"
@@ -17,7 +21,21 @@ namespace json = nlohmann;
 #include <string_view>
 #include <memory>
 #include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <thread>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <variant>
+#include <tuple>
+#include <type_traits>
+#include <future>
+#include <filesystem>
+namespace fs = std::filesystem;
 #include <chrono>
 namespace cr = std::chrono;
 
@@ -27,18 +45,123 @@ class DataStore
 public:
   using Ptr = DataStore *; // std::shared_ptr<DataStore>;
   using SharedMemory = Member::SharedMemory;
-  struct MemberConnections
+  using MemberConnections = ::MemberConnections;
+  using GraphView = ::GraphView;
+  //! compact record of a single new connection of a subscribed member
+  struct ConnectionUpdate
   {
-    MemberProxy member;
-    MemberProxies connections;
+    PrimaryKey member,
+               other;
+    bool       memberIsTopic,
+               otherIsTopic;
+  };
+  using ConnectionUpdates = std::vector<ConnectionUpdate>;
+  struct RetentionStatistics
+  {
+    size_t retained;  // number of currently retained members
+    size_t hits;      // number of lookups served by reviving a retained member
+    size_t misses;    // number of members that had to be requested from the IPC
+
+    friend std::ostream &operator<<(
+      std::ostream &stream,
+      const RetentionStatistics &statistics
+    )
+    {
+      stream << "{retained: " << statistics.retained << ", hits: " << statistics.hits << ", misses: " << statistics.misses << '}';
+      return stream;
+    }
   };
-  using GraphView = std::vector<MemberConnections>;
 
 private:
   using Nodes = DoubleLinkedList<Node>;
   using Topics = DoubleLinkedList<Topic>;
+  struct TopologyVertex
+  {
+    bool isTopic;
+    MemberProxies outgoing;
+  };
+  using Topology = std::unordered_map<PrimaryKey, TopologyVertex>;
+  using TopologyEdges = std::vector<std::pair<MemberProxy, MemberProxy>>;
+  using MemberUpdate = IpcReactor::Update;
+  //! the members of one key hash range, their part of the topology mirror
+  //! (i.e. their vertices and outgoing edges) and their pending updates
+  struct MemberShard
+  {
+    MemberShard(
+      size_t updateCapacity
+    ): updates(updateCapacity), nrBlockedDispatchers(0ul) {}
+
+    template<typename List>
+    List &getList()
+    {
+      if constexpr (std::is_same_v<List, Nodes>)
+        return nodes;
+      else
+        return topics;
+    }
+
+    Nodes         nodes;
+    Topics        topics;
+    std::mutex    insertMutex;
+
+    Topology      topology;
+    TopologyEdges backlog;
+    std::mutex    topologyMutex;
+
+    //! NOTE: applied by the shard's worker, while the queue is full the
+    //!       dispatching thread waits on spaceCondition
+    MpscQueue<MemberUpdate> updates;
+    std::mutex    spaceMutex;
+    std::condition_variable spaceCondition;
+    size_t        nrBlockedDispatchers;
+  };
+  struct PendingConnections
+  {
+    bool isTopic;
+    std::unordered_set<MemberProxy> connections;
+  };
+  using PendingUpdates = std::unordered_map<PrimaryKey, PendingConnections>;
+  using AttributeNames = std::vector<AttributeName>;
+  struct ReleasedMember
+  {
+    PrimaryKey primaryKey;
+    bool isTopic;
+  };
+  struct RetainedMember
+  {
+    PrimaryKey primaryKey;
+    bool isTopic;
+    Timestamp::rep releasedAt;
+  };
+  struct IgnoredTopics
+  {
+    PrimaryKey rosout,
+               parameterEvents;
+  };
+  struct PendingAttribute
+  {
+    Member *member;
+    AttributeName attribute;
+    size_t generation;
+    std::future<SingleAttributesResponse> response;
+  };
+  //! update subscription of a member inserted from the neighbourhood query,
+  //! requested once it is handed out
+  template<typename Response>
+  struct PendingSubscription
+  {
+    PrimaryKey primaryKey;
+    std::future<Response> response;
+  };
+  template<typename Response>
+  using PendingSubscriptions = std::vector<PendingSubscription<Response>>;
 
 public:
+  /**
+   * If there is a warm start snapshot, the ignored topics and the topology
+   * mirror are taken from it instead of being searched for and queried,
+   * so construction does not have to wait for the IPC.
+   */
   DataStore(
     const json::json &config
   );
@@ -58,10 +181,112 @@ public:
   const MemberPtr get(
     const MemberProxy &proxy
   ) { return (proxy.mIsTopic ? getTopic(proxy.mPrimaryKey) : getNode(proxy.mPrimaryKey)); }
+  /**
+   * Resolve multiple members at once.
+   *
+   * All member requests are sent before any response is awaited, so
+   * resolving N unknown members costs one pipelined round trip instead of N
+   * sequential ones.
+   *
+   * @param proxies members to resolve, may contain duplicates
+   * @return resolved members, in the same order as proxies
+   */
+  Members getMany(
+    const MemberProxies &proxies
+  );
+  /**
+   * Resolve the neighbourhood of the given members in bulk.
+   *
+   * Every member at most data-store.neighbourhood-hops edges away from any
+   * of the centres is fetched, together with its metadata and the edges in
+   * between, by custom queries of about 13 centres each (see
+   * makeNeighbourhoodQueries) and inserted into the store right away; the
+   * edges go into the topology mirror. The queries are all sent before the
+   * first response is awaited, so expanding around a whole frontier costs
+   * about one round trip instead of one per member.
+   *
+   * The inserted members are not subscribed to updates, as most of them are
+   * never looked at. Only once one is handed out by any of the lookups
+   * above, its subscription is requested, without waiting for it; it is
+   * collected by DataStore::run and until then the member misses its updates.
+   *
+   * @param centres members to start from
+   * @return the members of the neighbourhood, centres included; empty if
+   *         data-store.neighbourhood-hops is 0
+   */
+  Members getNeighbourhood(
+    const MemberProxies &centres
+  );
 
-  GraphView getFullGraphView() const;
+  /**
+   * Subscribe to the attributes of the given members, if not done already.
+   *
+   * Resolving a member does not subscribe to its attributes, as most members
+   * are only needed for their topology; only members entering the watchlist
+   * are subscribed. Which attributes are subscribed is configured per member
+   * type by data-store.node-attributes and data-store.topic-attributes, all
+   * requests of one call (i.e. every attribute of every member) are
+   * pipelined.
+   *
+   * @param members members to subscribe, invalid pointers are skipped
+   */
+  void subscribeAttributes(
+    const Members &members
+  );
+  /**
+   * Cancel the attribute subscriptions of the given members, if any.
+   */
+  void unsubscribeAttributes(
+    const Members &members
+  );
+
+  /**
+   * Get the whole (non ignored) graph topology.
+   *
+   * The topology is mirrored inside the data store: it is seeded once from
+   * the full graph query and afterwards kept up to date from the update
+   * stream handled in DataStore::run, so normally this is just an in-memory
+   * snapshot. As the update stream only covers subscribed members and
+   * never removes edges, the mirror is re-seeded every
+   * data-store.topology-refresh-interval-s seconds (0 disables this).
+   */
+  GraphView getFullGraphView();
   SharedMemory getCpuUtilisationMemory() const;
 
+  /**
+   * Awaitable versions of the above, to be run by executor.
+   *
+   * Instead of blocking on the IPC responses, these park the awaiting
+   * coroutine in the executor, so a single thread can have many of them in
+   * flight at once (e.g. by Executor::whenAll).
+   *
+   * @note the full graph query response is still parsed in one go, which
+   *       blocks the executor while it is streamed
+   */
+  Task<MemberPtr> coGetNode(
+    Executor &executor,
+    PrimaryKey primary
+  );
+  Task<MemberPtr> coGetTopic(
+    Executor &executor,
+    PrimaryKey primary
+  );
+  Task<MemberPtr> coGetTopicByName(
+    Executor &executor,
+    std::string name
+  );
+  Task<MemberPtr> coGet(
+    Executor &executor,
+    MemberProxy proxy
+  ) { return (proxy.mIsTopic ? coGetTopic(executor, proxy.mPrimaryKey) : coGetNode(executor, proxy.mPrimaryKey)); }
+  Task<GraphView> coGetFullGraphView(
+    Executor &executor
+  );
+  Task<void> coSubscribeAttributes(
+    Executor &executor,
+    Members members
+  );
+
   void addSubUpdate(
     Nodes::iterator affected,
     PrimaryKey other
@@ -74,11 +299,63 @@ public:
     Topics::iterator affected,
     PrimaryKey other
   );
-  GraphView getUpdates();
+  /**
+   * Members without users are not dropped right away but retained for
+   * data-store.retention-grace-period-s seconds (at most
+   * data-store.retention-capacity of them, oldest go first), so members that
+   * are released and requested again shortly after, e.g. after a watchlist
+   * reset, don't need to be requested and subscribed again.
+   */
+  RetentionStatistics getRetentionStatistics() const;
+  /**
+   * Hand over the connection updates received since the last call.
+   *
+   * Updates are passed from DataStore::run through a lock free queue, only
+   * if that overflows they are spilled into a map instead, which is also
+   * drained here. Either way, every connection is handed over only once.
+   *
+   * @note must only be called from a single (consumer) thread
+   */
+  ConnectionUpdates getUpdates();
+  /**
+   * Block until there are updates to get or the deadline passed.
+   *
+   * @note must only be called from the thread calling getUpdates
+   * @return true if there are updates
+   */
+  bool waitForUpdates(
+    Timestamp deadline
+  ) { return mUpdateChannel.waitUntil(deadline) || mUpdatesSpilled.load(); }
+  /**
+   * Receive and apply member updates until running is unset.
+   *
+   * If data-store.warm-start-file is set, what the data store knows is
+   * written there every data-store.warm-start-interval-s seconds and once
+   * more when this returns. On the next start it is used right away (see
+   * DataStore::DataStore); the ignored topics and the topology are validated
+   * against the IPC in the background, the members by name lookups once they
+   * are first acquired.
+   *
+   * The members are partitioned by the hash of their primary key into
+   * max(K, 1) shards, K being data-store.update-shards, each with its own
+   * member lists, insertion lock and part of the topology mirror. With K > 0
+   * this thread only receives the updates and dispatches them to the worker
+   * thread of the updated member's shard, which applies them; so a member's
+   * updates are still applied in order and by a single thread. The
+   * connection updates of all shards are merged into the one stream
+   * returned by getUpdates.
+   */
   void run(
     const std::atomic<bool> &running,
     cr::milliseconds loopTargetInterval
   );
+  /**
+   * @note updates still waiting in the IPC message queue are not counted, the
+   *       queue is shared with the other IPC clients and their messages
+   *
+   * @return number of updates received from the IPC but not applied yet
+   */
+  size_t getBacklogDepth() const { return mBacklogDepth.load(); }
 
   static constexpr bool checkTopicNameIgnored(
     const std::string &memberName
@@ -99,21 +376,269 @@ private:
     bool updates
   );
 
+  GraphView queryFullGraphView() const;
+  GraphView parseFullGraphView(
+    const CustomMemberResponse &resp
+  ) const;
+  GraphView getTopologySnapshot();
+  /**
+   * @param force seed even though the mirror is not outdated yet
+   * @return true if the caller has to seed the mirror via seedTopology
+   */
+  bool tryBeginTopologySeed(
+    bool force
+  );
+  GraphView seedTopology();
+  GraphView seedTopology(
+    GraphView fullGraph,
+    Timestamp seedTime
+  );
+  void addUpdate(
+    const MemberProxy &affected,
+    const MemberProxy &other
+  );
+  void applyTopologyEdge(
+    const MemberProxy &from,
+    const MemberProxy &to
+  );
+  void applyTopologyEdgeInternal(
+    const MemberProxy &from,
+    const MemberProxy &to
+  );
+  MemberShard &getShard(
+    const PrimaryKey &primaryKey
+  ) { return *mShards[std::hash<PrimaryKey>()(primaryKey) % mShards.size()]; }
+  std::vector<std::unique_lock<std::mutex>> lockTopologyShards();
+  template<typename List>
+  typename List::PoolStatistics getPoolStatistics() const;
+
+  /**
+   * Mark the members as subscribed, expects mAttributeSubscriptionMutex to
+   * be locked.
+   *
+   * @return the members which were not subscribed before
+   */
+  std::vector<Member *> markSubscribed(
+    const Members &members
+  );
+  void addAttributeSources(
+    const std::vector<Member *> &members
+  );
+  std::vector<PendingAttribute> requestAttributeSources(
+    const std::vector<Member *> &members,
+    const IpcReactor::ResponseNotifier &notify = IpcReactor::ResponseNotifier()
+  );
+  void removeAttributeSources(
+    Member *member,
+    std::vector<requestId_t> &oUnsubscriptions
+  );
+
+  void runPolling(
+    const std::atomic<bool> &running,
+    cr::milliseconds loopTargetInterval
+  );
+  void runEventDriven(
+    const std::atomic<bool> &running,
+    cr::milliseconds loopTargetInterval
+  );
+  void handOverUpdate(
+    const std::atomic<bool> &running,
+    const MemberUpdate &update
+  );
+  void evictUnused();
+  /**
+   * @param subscribe whether to request the update subscription of a member
+   *                  inserted without one (see DataStore::getNeighbourhood)
+   */
+  template<typename Iterator>
+  MemberPtr acquire(
+    Iterator it,
+    bool subscribe = true
+  );
+  template<typename List>
+  MemberPtr acquireKnown(
+    const PrimaryKey &primary,
+    bool subscribe = true
+  );
+  template<typename List>
+  MemberPtr acquireKnownName(
+    const std::string &name
+  );
+  template<typename Iterator>
+  void requestUpdateSubscription(
+    Iterator it
+  );
+  /**
+   * Insert the member from a response, unless it is known already.
+   *
+   * @param updates whether the request subscribed to updates, which have to
+   *                be cancelled for a duplicate
+   */
+  template<typename Response>
+  MemberPtr insertResponse(
+    const Response &response,
+    bool updates
+  );
+  void collectUpdateSubscriptions();
+  template<typename List, typename Response>
+  void collectUpdateSubscriptions(
+    PendingSubscriptions<Response> &pending
+  );
+  void enqueueRelease(
+    const PrimaryKey &primaryKey,
+    bool isTopic
+  );
+  template<typename Iterator>
+  void retainIfUnused(
+    Iterator it,
+    bool isTopic,
+    Timestamp::rep now
+  );
+  template<typename List>
+  bool evictRetained(
+    const RetainedMember &retained,
+    std::vector<requestId_t> &oUnsubscriptions
+  );
+  void sendUnsubscribeRequests(
+    const std::vector<requestId_t> &subscriptions
+  );
+  IgnoredTopics searchIgnoredTopics(
+    const std::atomic<bool> &running
+  );
+  void loadWarmStart();
+  void validateWarmStart(
+    const std::atomic<bool> &running
+  );
+  void writeWarmStart();
+  void writeWarmStartIfDue(
+    Timestamp now
+  );
+  size_t receiveUpdates(
+    const std::atomic<bool> &running
+  );
+  void dispatchUpdate(
+    const std::atomic<bool> &running,
+    const MemberUpdate &update
+  );
+  void applyMemberUpdate(
+    const MemberUpdate &update
+  );
+  void runUpdateShard(
+    const std::atomic<bool> &running,
+    MemberShard &shard,
+    cr::milliseconds loopTargetInterval
+  );
+  void applyUpdate(
+    const NodePublishersToUpdate &update
+  );
+  void applyUpdate(
+    const NodeSubscribersToUpdate &update
+  );
+  void applyUpdate(
+    const NodeIsServerForUpdate &update
+  );
+  void applyUpdate(
+    const NodeIsClientOfUpdate &update
+  );
+  void applyUpdate(
+    const NodeIsActionServerForUpdate &update
+  );
+  void applyUpdate(
+    const NodeIsActionClientOfUpdate &update
+  );
+  void applyUpdate(
+    const NodeStateUpdate &update
+  );
+  void applyUpdate(
+    const TopicPublishersUpdate &update
+  );
+  void applyUpdate(
+    const TopicSubscribersUpdate &update
+  );
+
+  static NodeResponse makeNodeResponse(
+    const PrimaryKey &primary,
+    const json::json &properties
+  );
+  static TopicResponse makeTopicResponse(
+    const PrimaryKey &primary,
+    const json::json &properties
+  );
+  static CustomMemberRequest makeFullGraphRequest(
+    const std::string &query
+  );
+  static AttributeNames parseAttributeNames(
+    const json::json &config
+  );
   static IpcClient tryMakeIpcClient(
     const json::json &config
   );
 
 private:
-  Nodes         mNodes;
-  Topics        mTopics;
-  GraphView     mUpdates;
-  std::mutex    mNodesMutex,
-                mTopicsMutex,
-                mUpdatesMutex;
-  IpcClient     mIpcClient;
-
-  PrimaryKey    mTopicParameterEventsKey,
-                mTopicRosoutKey;
+  std::vector<std::unique_ptr<MemberShard>> mShards;
+  MpscQueue<ConnectionUpdate> mUpdateChannel;
+  std::atomic<bool> mUpdatesSpilled;
+  PendingUpdates mUpdates,
+                mUpdatesBack;
+  //! NOTE: all of these are locked on hot paths, so unlike elsewhere they are
+  //!       locked by std::lock_guard instead of the (logging) ScopeLock
+  std::mutex    mUpdatesMutex,
+                mAttributeSubscriptionMutex,
+                mPendingSubscriptionsMutex;
+  IpcReactor    mIpcReactor;
+  std::tuple<
+    PendingSubscriptions<NodeResponse>,
+    PendingSubscriptions<TopicResponse>
+  >             mPendingSubscriptions;
+
+  //! NOTE: the keys are either searched for up front, or taken from the warm
+  //!       start snapshot into the first slot and, if validating them yields
+  //!       something else, replaced by publishing the second slot once
+  IgnoredTopics mIgnoredTopics[2];
+  std::atomic<const IgnoredTopics *> mpIgnoredTopics;
+
+  std::unique_ptr<WarmStartFile> mpWarmStart;
+  std::atomic<bool> mWarmStartDiscarded;
+  Timestamp     mWarmStartWrittenAt;
+
+  //! NOTE: mTopologySeeding is only written while holding mTopologyMutex and
+  //!       every shard's topology mutex, so holding any one of them is
+  //!       enough to read it
+  std::mutex    mTopologyMutex;
+  Timestamp     mTopologySeedTime;
+  bool          mTopologySeeded,
+                mTopologySeeding;
+
+  //! NOTE: increased once an update is received, decreased once it is applied
+  std::atomic<size_t> mBacklogDepth;
+
+  //! NOTE: updates received by the reactor in the event driven mode, whose
+  //!       receiver blocks on mReceivedSpaceCondition while the queue is full
+  MpscQueue<MemberUpdate> mReceivedUpdates;
+  std::mutex          mReceivedSpaceMutex;
+  std::condition_variable mReceivedSpaceCondition;
+  size_t              mNrBlockedReaders;
+
+  MpscQueue<ReleasedMember> mReleaseQueue;
+  std::atomic<bool>   mReleaseQueueOverflowed;
+  std::deque<RetainedMember> mRetained;
+  std::atomic<size_t> mNrRetained,
+                      mRetentionHits,
+                      mRetentionMisses;
+
+  const bool              cmDrainUpdates;
+  const cr::milliseconds  cmDrainBudget;
+  const bool              cmEventDriven;
+  const cr::seconds       cmTopologyRefreshInterval;
+  const CustomMemberRequest cmFullGraphRequest;
+  const AttributeNames    cmNodeAttributes,
+                          cmTopicAttributes;
+  const size_t            cmRetentionCapacity;
+  const cr::seconds       cmRetentionGracePeriod;
+  const bool              cmShardWorkers;
+  const fs::path          cmWarmStartPath;
+  const cr::seconds       cmWarmStartInterval;
+  const size_t            cmNeighbourhoodHops;
 
   static DataStore smInstance;
 };
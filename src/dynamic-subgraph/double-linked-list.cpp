@@ -1,28 +1,30 @@
 #include "dynamic-subgraph/double-linked-list.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <new>
+#include <thread>
+#include <utility>
 
 
 template<>
 template<>
-_Element<Node>::_Element(_Element<Node> *prev, _Element<Node> *next, const NodeResponse &response, requestId_t requestId):
-  mPrev(prev),
-  mNext(next),
+_Element<Node>::_Element(const NodeResponse &response, requestId_t requestId):
   mData(Data{
     Node(response),
     requestId,
-    AtomicCounter(1ul)
+    AtomicCounter(1ul),
+    0
   })
 {}
 template<>
 template<>
-_Element<Topic>::_Element(_Element<Topic> *prev, _Element<Topic> *next, const TopicResponse &response, requestId_t requestId):
-  mPrev(prev),
-  mNext(next),
+_Element<Topic>::_Element(const TopicResponse &response, requestId_t requestId):
   mData(Data{
     Topic(response),
     requestId,
-    AtomicCounter(1ul)
+    AtomicCounter(1ul),
+    0
   })
 {}
 
@@ -38,153 +40,222 @@ _Iterator<T> &_Iterator<T>::operator=(const _Iterator<T> &other)
   return *this;
 }
 
-template<typename T>
-_Iterator<T> _Iterator<T>::operator++()
-{
-  assert(mpElement);
-  _Iterator<T> oldValue(mpElement);
-  mpElement = mpElement->mNext;
+template class _Iterator<Node>;
+template class _Iterator<Topic>;
+
 
-  return oldValue;
-}
 template<typename T>
-_Iterator<T> &_Iterator<T>::operator++(int)
+DoubleLinkedList<T>::Snapshot::Snapshot(const DoubleLinkedList<T> *list):
+  mpList(list)
 {
-  assert(mpElement);
-  mpElement = mpElement->mNext;
+  static thread_local const size_t stripe = std::hash<std::thread::id>()(std::this_thread::get_id()) % cNrReaderStripes;
+  ReaderStripe &readers = list->mReaderStripes[stripe];
 
-  return *this;
+  //! NOTE: if the epoch advanced before this snapshot was counted, the
+  //!       writer might have missed it, so it is counted on the new one
+  size_t epoch = list->mEpoch.load();
+  while (true)
+  {
+    mpReaders = &readers.nrReaders[epoch % 2ul];
+    mpReaders->fetch_add(1ul);
+
+    const size_t currentEpoch = list->mEpoch.load();
+    if (currentEpoch == epoch)
+      break;
+
+    mpReaders->fetch_sub(1ul);
+    epoch = currentEpoch;
+  }
 }
+
 template<typename T>
-_Iterator<T> _Iterator<T>::operator--()
+DoubleLinkedList<T>::iterator DoubleLinkedList<T>::Snapshot::find(const PrimaryKey &primary) const
 {
-  assert(mpElement);
-  _Iterator<T> oldValue(mpElement);
-  mpElement = mpElement->mPrev;
-
-  return oldValue;
+  return mpList->find(mpList->mPrimaryIndex, primary);
 }
+
 template<typename T>
-_Iterator<T> &_Iterator<T>::operator--(int)
+DoubleLinkedList<T>::iterator DoubleLinkedList<T>::Snapshot::findName(const std::string &name) const
 {
-  assert(mpElement);
-  mpElement = mpElement->mPrev;
-
-  return *this;
+  return mpList->find(mpList->mNameIndex, name);
 }
 
-template class _Iterator<Node>;
-template class _Iterator<Topic>;
-
 
 template<typename T>
-DoubleLinkedList<T>::DoubleLinkedList()
+DoubleLinkedList<T>::DoubleLinkedList():
+  mEpoch(0ul)
 {
-  mBegin = mEnd = nullptr;
+  for (ReaderStripe &readers: mReaderStripes)
+  {
+    readers.nrReaders[0].store(0ul);
+    readers.nrReaders[1].store(0ul);
+  }
 }
 
 template<typename T>
 DoubleLinkedList<T>::~DoubleLinkedList()
 {
-  if (!mBegin)
-  {
-    assert(!mEnd);
-    return;
-  }
-
-  element_type *current = mBegin;
-  while (current)
-  {
-    element_type *next = current->mNext;
-    //! NOTE: this is for peace of mind: the current should obviously be the previous of the next (say that 10 times in a row)
-    //!       similarly, if the next is invalid we must be the last in line, so we check for that
-    if (next)
-      assert(next->mPrev == current);
-    else
-      assert(current == mEnd);
-
-    delete current;
-    current = next;
-  }
+  //! NOTE: nobody may hold a snapshot at this point anyway
+  for (const Retired &retired: mRetired)
+    this->destroy(retired.element);
+  for (element_type *shadowed: mShadowed)
+    this->destroy(shadowed);
+  for (const IndexShard<PrimaryKey> &shard: mPrimaryIndex)
+    for (const auto &[primaryKey, element]: shard.elements)
+      this->destroy(element);
 }
 
 template<>
 template<>
 DoubleLinkedList<Node>::iterator DoubleLinkedList<Node>::emplace_back(const NodeResponse &response, requestId_t requestId)
 {
-  element_type *newElement = new element_type(mEnd, nullptr, response, requestId);
-  if (mEnd)
-    mEnd->mNext = newElement;
-  else
-    mBegin = newElement;
-  mEnd = newElement;
-
-  return iterator(newElement);
+  const std::lock_guard<std::mutex> scopedLock(mWriteMutex);
+  return this->link(new (this->allocate()) element_type(response, requestId));
 }
 
 template<>
 template<>
 DoubleLinkedList<Topic>::iterator DoubleLinkedList<Topic>::emplace_back(const TopicResponse &response, requestId_t requestId)
 {
-  element_type *newElement = new element_type(mEnd, nullptr, response, requestId);
-  if (mEnd)
-    mEnd->mNext = newElement;
-  else
-    mBegin = newElement;
-  mEnd = newElement;
-
-  return iterator(newElement);
+  const std::lock_guard<std::mutex> scopedLock(mWriteMutex);
+  return this->link(new (this->allocate()) element_type(response, requestId));
 }
 
 template<typename T>
-DoubleLinkedList<T>::iterator DoubleLinkedList<T>::erase(iterator it)
+DoubleLinkedList<T>::iterator DoubleLinkedList<T>::link(element_type *newElement)
 {
-  element_type
-    *curr = it.mpElement,
-    *prev = curr->mPrev,
-    *next = curr->mNext;
-  if (prev)
-    prev->mNext = next;
-  if (next)
-    next->mPrev = prev;
+  const T &instance = newElement->mData.instance;
+
+  //! NOTE: set before the element becomes reachable through the indices
+  if (mReleaseHook)
+    newElement->mData.useCounter.setZeroHook(&mReleaseHook, instance.mPrimaryKey);
 
-  delete curr;
+  if (element_type *shadowed = this->insert(mPrimaryIndex, instance.mPrimaryKey, newElement))
+    mShadowed.push_back(shadowed);
+  this->insert(mNameIndex, instance.mName, newElement);
 
-  return iterator(next);
+  return iterator(newElement);
 }
 
 template<typename T>
-DoubleLinkedList<T>::iterator DoubleLinkedList<T>::find(const PrimaryKey &primary)
+void DoubleLinkedList<T>::erase(iterator it)
 {
-  for (iterator it = this->begin(); it != this->end(); ++it)
-    if (it->instance.mPrimaryKey == primary)
-      return it;
+  const std::lock_guard<std::mutex> scopedLock(mWriteMutex);
+
+  element_type *curr = it.mpElement;
+
+  const T &instance = curr->mData.instance;
+  if (!this->remove(mPrimaryIndex, instance.mPrimaryKey, curr))
+    std::erase(mShadowed, curr);
+  this->remove(mNameIndex, instance.mName, curr);
+
+  //! NOTE: tagged after it became unreachable, so snapshots of later epochs
+  //!       can not have seen it
+  mRetired.push_back(Retired{
+    .element = curr,
+    .epoch = mEpoch.load()
+  });
+  this->reclaimRetired();
+}
 
-  return this->end();
+template<typename T>
+void DoubleLinkedList<T>::reclaim()
+{
+  const std::lock_guard<std::mutex> scopedLock(mWriteMutex);
+  this->reclaimRetired();
 }
 
-template<>
-DoubleLinkedList<Node>::iterator DoubleLinkedList<Node>::findName(const std::string &name)
+template<typename T>
+void DoubleLinkedList<T>::reclaimRetired()
 {
-  for (iterator it = this->begin(); it != this->end(); ++it)
+  //! NOTE: only writers advance the epoch; it may move on once no snapshot
+  //!       of the previous one is left (same parity as the next one), so at
+  //!       most two epochs are alive at any time; it only has to get as far
+  //!       as the newest retired element needs it to
+  size_t epoch = mEpoch.load();
+  for (size_t step = 0ul; step < 2ul && !mRetired.empty() && mRetired.back().epoch + 2ul > epoch && !this->hasReaders((epoch + 1ul) % 2ul); ++step)
+    mEpoch.store(++epoch);
+
+  while (!mRetired.empty() && mRetired.front().epoch + 2ul <= epoch)
   {
-    if (it->instance.mName == name)
-      return it;
+    this->destroy(mRetired.front().element);
+    mRetired.pop_front();
   }
+}
 
-  return this->end();
+template<typename T>
+bool DoubleLinkedList<T>::hasReaders(size_t parity) const
+{
+  for (const ReaderStripe &readers: mReaderStripes)
+    if (readers.nrReaders[parity].load() != 0ul)
+      return true;
+
+  return false;
 }
 
-template<>
-DoubleLinkedList<Topic>::iterator DoubleLinkedList<Topic>::findName(const std::string &name)
+template<typename T>
+template<typename Key>
+DoubleLinkedList<T>::iterator DoubleLinkedList<T>::find(const IndexShard<Key> (&index)[cNrIndexShards], const Key &key) const
 {
-  for (iterator it = this->begin(); it != this->end(); ++it)
-  {
-    if (it->instance.mName == name)
-      return it;
-  }
+  const IndexShard<Key> &shard = index[getShardIndex(key)];
+  const std::shared_lock<std::shared_mutex> scopedLock(shard.mutex);
+
+  typename std::unordered_map<Key, element_type *>::const_iterator it = shard.elements.find(key);
+  if (it == shard.elements.end())
+    return iterator(nullptr);
+
+  return iterator(it->second);
+}
+
+template<typename T>
+template<typename Key>
+DoubleLinkedList<T>::element_type *DoubleLinkedList<T>::insert(IndexShard<Key> (&index)[cNrIndexShards], const Key &key, element_type *element)
+{
+  IndexShard<Key> &shard = index[getShardIndex(key)];
+  const std::lock_guard<std::shared_mutex> scopedLock(shard.mutex);
+
+  //! NOTE: if a member is (for whatever reason) added twice, the newer element
+  //!       shadows the older one until that is erased
+  element_type *&indexed = shard.elements[key];
+  return std::exchange(indexed, element);
+}
 
-  return this->end();
+template<typename T>
+template<typename Key>
+bool DoubleLinkedList<T>::remove(IndexShard<Key> (&index)[cNrIndexShards], const Key &key, element_type *element)
+{
+  IndexShard<Key> &shard = index[getShardIndex(key)];
+  const std::lock_guard<std::shared_mutex> scopedLock(shard.mutex);
+
+  typename std::unordered_map<Key, element_type *>::iterator it = shard.elements.find(key);
+  if (it == shard.elements.end() || it->second != element)
+    return false;
+
+  shard.elements.erase(it);
+  return true;
+}
+
+template<typename T>
+void *DoubleLinkedList<T>::allocate()
+{
+  const std::lock_guard<std::mutex> scopedLock(mPoolMutex);
+  return mPool.allocate();
+}
+
+template<typename T>
+void DoubleLinkedList<T>::destroy(element_type *element)
+{
+  element->~element_type();
+
+  const std::lock_guard<std::mutex> scopedLock(mPoolMutex);
+  mPool.deallocate(element);
+}
+
+template<typename T>
+DoubleLinkedList<T>::PoolStatistics DoubleLinkedList<T>::getPoolStatistics() const
+{
+  const std::lock_guard<std::mutex> scopedLock(mPoolMutex);
+  return mPool.getStatistics();
 }
 
 template class DoubleLinkedList<Node>;
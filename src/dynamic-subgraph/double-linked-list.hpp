@@ -2,10 +2,27 @@
 
 #include "dynamic-subgraph/members.hpp"
 #include "dynamic-subgraph/atomic-counter.hpp"
+#include "dynamic-subgraph/slab-pool.hpp"
 
 #include "ipc/datastructs/information-datastructs.hpp"
 #include "ipc/common.hpp"
 
+#include <string>
+#include <unordered_map>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+#include <limits>
+
+
+//! requestId of an element whose update subscription is not requested (yet)
+inline constexpr requestId_t cNoSubscription = std::numeric_limits<requestId_t>::max();
+//! requestId of an element whose update subscription is requested but not established yet
+inline constexpr requestId_t cSubscriptionRequested = std::numeric_limits<requestId_t>::max() - 1;
 
 template<typename T>
 class _Element
@@ -13,38 +30,40 @@ class _Element
 public:
   struct Data {
     T instance;
-    requestId_t requestId;
+    std::atomic<requestId_t> requestId;
     AtomicCounter useCounter;
+    //! time (since epoch) the member was retained after losing its last user, 0 if in use
+    std::atomic<Timestamp::rep> releasedAt;
   };
 
 public:
   template<typename U>
   _Element(
-    _Element<T> *prev,
-    _Element<T> *next,
     const U &request,
     requestId_t requestId
   );
 
 public:
-  _Element *mPrev, *mNext;
   Data mData;
 };
 
 template<>
 template<>
-_Element<Node>::_Element(_Element<Node> *prev, _Element<Node> *next, const NodeResponse &response, requestId_t requestId);
+_Element<Node>::_Element(const NodeResponse &response, requestId_t requestId);
 template<>
 template<>
-_Element<Topic>::_Element(_Element<Topic> *prev, _Element<Topic> *next, const TopicResponse &response, requestId_t requestId);
+_Element<Topic>::_Element(const TopicResponse &response, requestId_t requestId);
 
 
+/**
+ * Handle of a single element, as handed out by a snapshot's lookups; there
+ * is no order among the elements to step through, Snapshot::forEach visits
+ * all of them.
+ */
 template<typename T>
 class _Iterator
 {
 public:
-  using iterator_category = std::random_access_iterator_tag;
-  using difference_type   = std::ptrdiff_t;
   using value_type        = _Element<T>::Data;
   using value_pointer     = _Element<T>::Data*;
   using value_reference   = _Element<T>::Data&;
@@ -58,11 +77,6 @@ public:
   {}
   _Iterator<T> &operator=(const _Iterator<T> &other);
 
-  _Iterator<T> operator++();
-  _Iterator<T> &operator++(int);
-  _Iterator<T> operator--();
-  _Iterator<T> &operator--(int);
-
   value_reference operator*() { return mpElement->mData; }
   const value_reference operator*() const { return mpElement->mData; }
   value_pointer operator->() { return &(mpElement->mData); }
@@ -77,6 +91,25 @@ public:
 };
 
 
+/**
+ * Member container of the data store, safe for concurrent readers.
+ *
+ * The lookup indices are split into cNrIndexShards shards by key hash, each
+ * guarded by its own shared mutex, so a lookup only briefly shares the lock
+ * of one shard and a writer (emplace_back, erase) only excludes readers of
+ * the shards it touches. Writers are serialised among each other.
+ *
+ * Erased elements are unlinked right away but only destroyed once no
+ * Snapshot that could still reach them is alive (epoch based reclamation):
+ * every snapshot is counted on the epoch it started in, an erased element is
+ * tagged with the current epoch, and the epoch only advances once no
+ * snapshot of the one before it is left, so an element is safe to destroy
+ * two epochs after it was tagged. Reclaiming happens in erase and reclaim,
+ * i.e. destructors only ever run on the erasing thread, never on a reader.
+ *
+ * Iterators obtained from a snapshot must only be dereferenced while the
+ * snapshot is alive, or while the element is otherwise known to be in use.
+ */
 template<typename T>
 class DoubleLinkedList
 {
@@ -85,9 +118,79 @@ public:
   using iterator = _Iterator<T>;
   using const_iterator = const _Iterator<T>;
 
+  using PoolStatistics = SlabPool<_Element<T>>::Statistics;
+  //! called with the key of the element whose use counter just dropped to
+  //! zero, from the releasing thread; the element may already be gone
+  using ReleaseHook = AtomicCounter::ZeroHook;
+
 private:
   using element_type = _Element<T>;
 
+  static constexpr size_t cIndexShardBits = 4ul;
+  static constexpr size_t cNrIndexShards = 1ul << cIndexShardBits;
+  static constexpr size_t cNrReaderStripes = 16ul;
+
+  //! NOTE: the indices only hold raw element pointers, which stay valid until
+  //!       the element is reclaimed, so iterators are unaffected by rehashing
+  template<typename Key>
+  struct alignas(64) IndexShard
+  {
+    mutable std::shared_mutex               mutex;
+    std::unordered_map<Key, element_type *> elements;
+  };
+  //! number of snapshots alive per epoch parity, striped to keep readers on
+  //! different threads off each others cache lines
+  struct alignas(64) ReaderStripe
+  {
+    std::atomic<size_t> nrReaders[2];
+  };
+  struct Retired
+  {
+    element_type *element;
+    size_t        epoch;
+  };
+
+public:
+  class Snapshot
+  {
+  friend class DoubleLinkedList<T>;
+
+  public:
+    Snapshot(const Snapshot &) = delete;
+    Snapshot &operator=(const Snapshot &) = delete;
+    ~Snapshot() { mpReaders->fetch_sub(1ul); }
+
+    iterator find(const PrimaryKey &primary) const;
+    iterator findName(const std::string &name) const;
+    constexpr iterator end() const { return iterator(nullptr); }
+
+    /**
+     * @note function is called with the shared lock of an index shard held,
+     *       so it must not modify the list
+     */
+    template<typename Function>
+    void forEach(
+      Function &&function
+    ) const
+    {
+      for (const IndexShard<PrimaryKey> &shard: mpList->mPrimaryIndex)
+      {
+        const std::shared_lock<std::shared_mutex> scopedLock(shard.mutex);
+        for (const auto &[primaryKey, element]: shard.elements)
+          function(iterator(element));
+      }
+    }
+
+  private:
+    Snapshot(
+      const DoubleLinkedList<T> *list
+    );
+
+  private:
+    const DoubleLinkedList<T> *mpList;
+    std::atomic<size_t>       *mpReaders;
+  };
+
 public:
   DoubleLinkedList();
   ~DoubleLinkedList();
@@ -95,28 +198,91 @@ public:
   template<typename U>
   iterator emplace_back(const U &response, requestId_t requestId);
 
-  iterator erase(iterator it);
+  void erase(iterator it);
+  /**
+   * Destroy the erased elements no snapshot can reach anymore. erase does so
+   * as well, this is for when there was nothing to erase for a while.
+   *
+   * @note call it from the erasing thread, so destructors stay off readers
+   */
+  void reclaim();
+
+  Snapshot snapshot() const { return Snapshot(this); }
 
-  iterator find(const PrimaryKey &primary);
-  iterator findName(const std::string &name);
+  PoolStatistics getPoolStatistics() const;
+  /**
+   * @note only affects elements emplaced afterwards, so set it before any
+   */
+  void setReleaseHook(
+    ReleaseHook hook
+  ) { mReleaseHook = std::move(hook); }
+
+private:
+  void *allocate();
+  void destroy(
+    element_type *element
+  );
+  iterator link(
+    element_type *newElement
+  );
+  void reclaimRetired();
+  bool hasReaders(
+    size_t parity
+  ) const;
 
-  iterator begin() { return iterator(mBegin); }
-  constexpr iterator end() { return iterator(nullptr); }
+  template<typename Key>
+  static size_t getShardIndex(
+    const Key &key
+  )
+  {
+    //! NOTE: fibonacci hashing, so the shard depends on all bits of the hash
+    return (std::hash<Key>()(key) * 0x9E3779B97F4A7C15ull) >> (64ul - cIndexShardBits);
+  }
+  template<typename Key>
+  iterator find(
+    const IndexShard<Key> (&index)[cNrIndexShards],
+    const Key &key
+  ) const;
+  /**
+   * @return the element shadowed by element, if there was one under key
+   */
+  template<typename Key>
+  element_type *insert(
+    IndexShard<Key> (&index)[cNrIndexShards],
+    const Key &key,
+    element_type *element
+  );
+  /**
+   * @return whether element was the one indexed under key
+   */
+  template<typename Key>
+  bool remove(
+    IndexShard<Key> (&index)[cNrIndexShards],
+    const Key &key,
+    element_type *element
+  );
 
 private:
-  element_type *mBegin, *mEnd;
+  SlabPool<element_type> mPool;
+  mutable std::mutex  mPoolMutex;
+  std::mutex          mWriteMutex;
+  IndexShard<PrimaryKey>  mPrimaryIndex[cNrIndexShards];
+  IndexShard<std::string> mNameIndex[cNrIndexShards];
+  std::atomic<size_t> mEpoch;
+  mutable ReaderStripe mReaderStripes[cNrReaderStripes];
+  //! NOTE: only touched with mWriteMutex held, ordered by epoch
+  std::deque<Retired> mRetired;
+  //! NOTE: only touched with mWriteMutex held; the elements which are not
+  //!       erased but shadowed in the primary index by a newer one with the
+  //!       same key, everything else is owned through that index
+  std::vector<element_type *> mShadowed;
+  ReleaseHook         mReleaseHook;
 };
 
 template<>
 template<>
 DoubleLinkedList<Node>::iterator DoubleLinkedList<Node>::emplace_back(const NodeResponse &response, requestId_t requestId);
 
-template<>
-DoubleLinkedList<Node>::iterator DoubleLinkedList<Node>::findName(const std::string &name);
-
 template<>
 template<>
 DoubleLinkedList<Topic>::iterator DoubleLinkedList<Topic>::emplace_back(const TopicResponse &response, requestId_t requestId);
-
-template<>
-DoubleLinkedList<Topic>::iterator DoubleLinkedList<Topic>::findName(const std::string &name);
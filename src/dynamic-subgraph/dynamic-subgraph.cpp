@@ -7,7 +7,12 @@ using namespace std::chrono_literals;
 
 
 DynamicSubgraphBuilder::DynamicSubgraphBuilder(const json::json &config, DataStore::Ptr dataStorePtr):
-  mWatchlist(config.at(CONFIG_WATCHLIST), dataStorePtr),
+  mWatchlist(dataStorePtr),
+  mNameResolver(
+    config.at(CONFIG_NAME_RESOLVER),
+    dataStorePtr,
+    [this](MemberPtr member) { mWatchlist.addMember(std::move(member), Watchlist::TYPE_INITIAL); }
+  ),
   mFD(config, &mWatchlist),
   mpDataStore(dataStorePtr),
   mSomethingIsGoingOn(false),
@@ -20,6 +25,12 @@ DynamicSubgraphBuilder::DynamicSubgraphBuilder(const json::json &config, DataSto
 {
   LOG_TRACE(LOG_THIS LOG_VAR(config) LOG_VAR(dataStorePtr));
 
+  //! TODO: when this also accepts topics eventually, we should probably clean from ignored topics
+  const json::json &initialMembers = config.at(CONFIG_WATCHLIST);
+  if (!initialMembers.is_null())
+    for (const std::string &name: initialMembers.get<std::vector<std::string>>())
+      mNameResolver.addName(name);
+
   mCpuUtilisationSource = mpDataStore->getCpuUtilisationMemory();
 }
 
@@ -30,8 +41,9 @@ void DynamicSubgraphBuilder::run(const std::atomic<bool> &running)
   std::thread faultDetection(&FaultDetection::run, &mFD, std::cref(running), cmLoopTargetInterval);
   std::thread dataStore(&DataStore::run, mpDataStore, std::cref(running), cmLoopTargetInterval);
   std::thread visualisation(&Graph::visualise, &mSAG, std::cref(running), cmLoopTargetInterval);
+  std::thread nameResolution(&NameResolver::run, &mNameResolver, std::cref(running), cmLoopTargetInterval);
 
-  Timestamp start, stop;
+  Timestamp start;
   while (running.load())
   {
     start = cr::system_clock::now();
@@ -47,19 +59,7 @@ void DynamicSubgraphBuilder::run(const std::atomic<bool> &running)
       blindSpotCheck();
     mBlindSpotCheckCounter = (mBlindSpotCheckCounter + 1) % cmBlindspotInterval;
 
-    DataStore::GraphView updates = mpDataStore->getUpdates();
-    LOG_INFO("Got " << updates.size() << " updates.");
-    if (!updates.empty())
-    {
-      for (const DataStore::MemberConnections &update: updates)
-      {
-        if (!mSAG.contains(update.member))
-          continue;
-        for (const MemberProxy &member: update.connections)
-          if (!mWatchlist.contains(member.mPrimaryKey))
-            mWatchlist.addMember(member);
-      }
-    }
+    size_t nrUpdates = processUpdates();
 
     Alerts emittedAlerts = mFD.getEmittedAlerts();
     LOG_INFO("Got " << emittedAlerts.size() << " alerts.");
@@ -81,16 +81,39 @@ void DynamicSubgraphBuilder::run(const std::atomic<bool> &running)
 
     //! TODO: std::move emittedAlerts into FTE-Alert-DB
 
-    stop = cr::system_clock::now();
-    cr::milliseconds remainingTime = cmLoopTargetInterval - cr::duration_cast<cr::milliseconds>(stop - start);
-    if (remainingTime.count() > 0)
-      std::this_thread::sleep_for(remainingTime);
+    // instead of sleeping for the rest of the cycle, handle updates as they come in
+    const Timestamp deadline = start + cmLoopTargetInterval;
+    while (running.load() && cr::system_clock::now() < deadline && mpDataStore->waitForUpdates(deadline))
+      nrUpdates += processUpdates();
+    LOG_DEBUG("Got " << nrUpdates << " updates.");
   }
   LOG_INFO("Dynamic Subgraph Builder mainloop terminated.");
 
   faultDetection.join();
   dataStore.join();
   visualisation.join();
+  nameResolution.join();
+}
+
+size_t DynamicSubgraphBuilder::processUpdates()
+{
+  LOG_TRACE(LOG_THIS);
+
+  DataStore::ConnectionUpdates updates = mpDataStore->getUpdates();
+  if (updates.empty())
+    return 0ul;
+
+  MemberProxies newMembers;
+  for (const DataStore::ConnectionUpdate &update: updates)
+  {
+    if (!mSAG.contains(MemberProxy(update.member, update.memberIsTopic)))
+      continue;
+    if (!mWatchlist.contains(update.other))
+      newMembers.emplace_back(update.other, update.otherIsTopic);
+  }
+  mWatchlist.addMembers(newMembers);
+
+  return updates.size();
 }
 
 static void getBlindspotsInternal(
@@ -167,20 +190,33 @@ void DynamicSubgraphBuilder::blindSpotCheck()
   MemberProxies potentialBlindSpots = ::getBlindspots(std::move(fullGraph));
   // LOG_DEBUG(LOG_VAR(potentialBlindSpots));
 
-  for (const MemberProxy &member: potentialBlindSpots)
-    mWatchlist.addMember(member, Watchlist::TYPE_BLINDSPOT);
+  mWatchlist.addMembers(potentialBlindSpots, Watchlist::TYPE_BLINDSPOT);
 }
 
 void DynamicSubgraphBuilder::expandSubgraph(const Alerts &newAlerts)
 {
   LOG_TRACE(LOG_THIS);
 
+  MemberProxies newVertices,
+                incomingMembers;
   for (const Alert &alert: newAlerts)
   {
     if (mSAG.add(alert.member))
-      for (const MemberProxy &incomingMember: mSAG.getIncoming(alert.member))
-        mWatchlist.addMember(incomingMember);
+    {
+      newVertices.emplace_back(alert.member->mPrimaryKey, alert.member->mIsTopic);
+      MemberProxies incoming = mSAG.getIncoming(alert.member);
+      std::move(incoming.begin(), incoming.end(), std::back_inserter(incomingMembers));
+    }
   }
+  //! NOTE: populates the data store in bulk, so the members resolved below
+  //!       (and likely the next expansion's) are known already
+  //! NOTE: never read, it only pins the members (every MemberPtr holds a use)
+  //!       until they are in the watchlist, so they don't end up in retention
+  //!       and get evicted before coAddMembers acquires them
+  const Members pinnedNeighbourhood = mpDataStore->getNeighbourhood(newVertices);
+  //! NOTE: resolving and subscribing the members is fanned out on this
+  //!       thread, instead of waiting for them one batch after another
+  mExecutor.run(mWatchlist.coAddMembers(mExecutor, std::move(incomingMembers)));
   mSAG.updateVisualisation();
 }
 
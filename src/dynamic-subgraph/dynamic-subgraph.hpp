@@ -2,6 +2,8 @@
 
 #include "dynamic-subgraph/data-store.hpp"
 #include "dynamic-subgraph/graph.hpp"
+#include "dynamic-subgraph/name-resolver.hpp"
+#include "dynamic-subgraph/task.hpp"
 #include "fault-detection/fault-detection.hpp"
 #include "fault-detection/watchlist.hpp"
 #include "fault-detection/circular-buffer.hpp"
@@ -36,6 +38,10 @@ public:
   );
 
 private:
+  /**
+   * @return number of updates processed
+   */
+  size_t processUpdates();
   void blindSpotCheck();
 
   void expandSubgraph(
@@ -48,11 +54,13 @@ private:
 
 private:
   Watchlist                 mWatchlist;
+  NameResolver              mNameResolver;
   FaultDetection            mFD;
   FaultTrajectoryExtraction mFTE;
   Graph                     mSAG;
   DataStore::Ptr            mpDataStore;
   DataStore::SharedMemory   mCpuUtilisationSource;
+  Executor                  mExecutor;
 
   bool                      mSomethingIsGoingOn;
   CircularBuffer            mLastNrAlerts;
@@ -0,0 +1,273 @@
+#include "dynamic-subgraph/graph-query-parser.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+
+
+ShmTextStreamBuffer::ShmTextStreamBuffer(SharedMemory &channel):
+  mrChannel(channel),
+  mResponse(MAKE_RESPONSE),
+  mPreviousNumber(0ul),
+  mDone(false)
+{}
+
+ShmTextStreamBuffer::int_type ShmTextStreamBuffer::underflow()
+{
+  // the current chunk might be empty, so keep receiving until there is something to read
+  while (!mDone)
+  {
+    mrChannel.receive(mResponse);
+    assert(mResponse.header.type == sharedMem::ResponseType::TEXTUAL);
+    assert(mPreviousNumber < mResponse.textual.number);
+    mPreviousNumber = mResponse.textual.number;
+    if (mResponse.textual.number % 10 == 0)
+      LOG_DEBUG("Receiving package " << mResponse.textual.number << '/' << mResponse.textual.total);
+    mDone = (mResponse.textual.number >= mResponse.textual.total);
+
+    char *begin = mResponse.textual.line;
+    size_t length = ::strnlen(begin, sizeof(mResponse.textual.line));
+    if (length == 0ul)
+      continue;
+
+    this->setg(begin, begin, begin + length);
+    return traits_type::to_int_type(*begin);
+  }
+
+  return traits_type::eof();
+}
+
+
+GraphQuerySaxHandler::GraphQuerySaxHandler(bool withProperties):
+  mSection(SECTION_NONE),
+  mSectionDepth(0ul),
+  mCurrentEdgeValid(false),
+  mCurrentProperties(json::json::object()),
+  cmWithProperties(withProperties)
+{}
+
+bool GraphQuerySaxHandler::null()
+{
+  if (!isEdgeSection() || mFrames.size() != mSectionDepth + 2ul)
+    return true;
+
+  // a null relationship means there is no such edge (OPTIONAL MATCH), same for null endpoints
+  const std::string &key = mFrames.back().key;
+  if (key == "rel" || key == "from" || key == "to")
+    mCurrentEdgeValid = false;
+
+  return true;
+}
+
+bool GraphQuerySaxHandler::string(string_t &value)
+{
+  if (mSection == SECTION_NONE)
+    return true;
+
+  size_t depth = mFrames.size();
+  if (isEdgeSection())
+  {
+    Endpoint endpoint = currentEndpoint();
+    if (endpoint != ENDPOINT_NONE)
+      setEndpoint(endpoint, value);
+    return true;
+  }
+
+  // vertices, either as plain primary key inside the array or as object with a primary key
+  if (depth == mSectionDepth + 1ul && mFrames.back().isArray)
+    this->addVertex(value);
+  else if (isVertexObject())
+  {
+    //! NOTE: added once the object is complete, the properties might come after the key
+    if (mFrames.back().key == "primaryKey")
+      mCurrentVertex = value;
+    else if (cmWithProperties)
+      mCurrentProperties[mFrames.back().key] = value;
+  }
+
+  return true;
+}
+
+bool GraphQuerySaxHandler::number_integer(number_integer_t value)
+{
+  if (cmWithProperties && isVertexObject())
+    mCurrentProperties[mFrames.back().key] = value;
+
+  return true;
+}
+
+bool GraphQuerySaxHandler::number_unsigned(number_unsigned_t value)
+{
+  if (cmWithProperties && isVertexObject())
+    mCurrentProperties[mFrames.back().key] = value;
+
+  return true;
+}
+
+bool GraphQuerySaxHandler::start_object(std::size_t)
+{
+  mFrames.push_back(Frame{.isArray = false, .key = std::string()});
+
+  // new edge
+  if (isEdgeSection() && mFrames.size() == mSectionDepth + 2ul)
+  {
+    mCurrentEdge = Edge{
+      .type = (mSection == SECTION_PUB ? EDGE_PUB : (mSection == SECTION_SUB ? EDGE_SUB : EDGE_SEND)),
+      .from = PrimaryKey(),
+      .to = PrimaryKey()
+    };
+    mCurrentEdgeValid = true;
+  }
+
+  return true;
+}
+
+bool GraphQuerySaxHandler::key(string_t &value)
+{
+  assert(!mFrames.empty() && !mFrames.back().isArray);
+  mFrames.back().key = value;
+
+  return true;
+}
+
+bool GraphQuerySaxHandler::end_object()
+{
+  if (isEdgeSection() && mFrames.size() == mSectionDepth + 2ul)
+  {
+    if (mCurrentEdgeValid && !mCurrentEdge.from.empty() && !mCurrentEdge.to.empty())
+      mEdges.push_back(mCurrentEdge);
+    mCurrentEdgeValid = false;
+  }
+  else if (isVertexObject())
+  {
+    if (!mCurrentVertex.empty())
+      this->addVertex(mCurrentVertex);
+    mCurrentVertex.clear();
+    mCurrentProperties = json::json::object();
+  }
+
+  assert(!mFrames.empty());
+  mFrames.pop_back();
+
+  return true;
+}
+
+bool GraphQuerySaxHandler::start_array(std::size_t)
+{
+  if (mSection == SECTION_NONE && !mFrames.empty() && !mFrames.back().isArray)
+  {
+    const std::string &key = mFrames.back().key;
+    Section section = SECTION_NONE;
+    if (key == "active")
+      section = SECTION_ACTIVE;
+    else if (key == "passive")
+      section = SECTION_PASSIVE;
+    else if (key == "pub")
+      section = SECTION_PUB;
+    else if (key == "sub")
+      section = SECTION_SUB;
+    else if (key == "send")
+      section = SECTION_SEND;
+
+    if (section != SECTION_NONE)
+    {
+      mSection = section;
+      mSectionDepth = mFrames.size();
+    }
+  }
+
+  mFrames.push_back(Frame{.isArray = true, .key = std::string()});
+
+  return true;
+}
+
+bool GraphQuerySaxHandler::end_array()
+{
+  assert(!mFrames.empty());
+  mFrames.pop_back();
+
+  if (mSection != SECTION_NONE && mFrames.size() == mSectionDepth)
+    mSection = SECTION_NONE;
+
+  return true;
+}
+
+bool GraphQuerySaxHandler::parse_error(std::size_t position, const std::string &lastToken, const json::detail::exception &exception)
+{
+  LOG_ERROR("Failed to parse graph query response at " << position << " (last token: '" << lastToken << "'): " << exception.what());
+
+  return false;
+}
+
+GraphQuerySaxHandler::Endpoint GraphQuerySaxHandler::currentEndpoint() const
+{
+  // frames: ... section array (mSectionDepth), edge object, [endpoint object]
+  size_t depth = mFrames.size();
+  const std::string *endpointKey = nullptr;
+  if (depth == mSectionDepth + 2ul)
+    endpointKey = &mFrames.back().key;
+  else if (depth == mSectionDepth + 3ul && !mFrames.back().isArray && mFrames.back().key == "primaryKey")
+    endpointKey = &mFrames[depth - 2ul].key;
+  else
+    return ENDPOINT_NONE;
+
+  if (*endpointKey == "from")
+    return ENDPOINT_FROM;
+  if (*endpointKey == "to")
+    return ENDPOINT_TO;
+  return ENDPOINT_NONE;
+}
+
+void GraphQuerySaxHandler::addVertex(const std::string &primaryKey)
+{
+  mVertices.emplace_back(PrimaryKey(primaryKey), mSection == SECTION_PASSIVE);
+  if (cmWithProperties)
+    mProperties.push_back(std::exchange(mCurrentProperties, json::json::object()));
+}
+
+void GraphQuerySaxHandler::setEndpoint(Endpoint endpoint, const std::string &primaryKey)
+{
+  (endpoint == ENDPOINT_FROM ? mCurrentEdge.from : mCurrentEdge.to) = PrimaryKey(primaryKey);
+}
+
+
+GraphView assembleGraphView(const GraphQuerySaxHandler &handler, const std::function<bool(const PrimaryKey &)> &isIgnoredTopic)
+{
+  // construct graph vertices, remembering where each one ended up
+  GraphView output;
+  std::unordered_map<PrimaryKey, size_t> vertexIndices;
+  output.reserve(handler.getVertices().size());
+  vertexIndices.reserve(handler.getVertices().size());
+  for (const MemberProxy &vertex: handler.getVertices())
+  {
+    if (vertex.mIsTopic && isIgnoredTopic(vertex.mPrimaryKey))
+      continue;
+
+    LOG_TRACE("Adding " << vertex << " to graph");
+    vertexIndices.emplace(vertex.mPrimaryKey, output.size());
+    output.emplace_back(vertex, MemberProxies());
+  }
+
+  // construct graph edges
+  for (const GraphQuerySaxHandler::Edge &edge: handler.getEdges())
+  {
+    // sub: topic -> node, pub: node -> topic, send: node -> node
+    if ((edge.type == GraphQuerySaxHandler::EDGE_SUB && isIgnoredTopic(edge.from)) ||
+        (edge.type == GraphQuerySaxHandler::EDGE_PUB && isIgnoredTopic(edge.to)))
+      continue;
+
+    std::unordered_map<PrimaryKey, size_t>::const_iterator indexIt = vertexIndices.find(edge.from);
+    if (indexIt == vertexIndices.end() || !vertexIndices.contains(edge.to))
+    {
+      LOG_WARN("Edge from " << edge.from << " to " << edge.to << " has an endpoint which is no vertex of the graph, skipping it.");
+      continue;
+    }
+
+    MemberConnections &vertex = output[indexIt->second];
+    LOG_TRACE("Adding connection from " << vertex.member << " to " << edge.to << " to graph");
+    vertex.connections.emplace_back(edge.to, edge.type == GraphQuerySaxHandler::EDGE_PUB);
+  }
+
+  return output;
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "dynamic-subgraph/member-base.hpp"
+#include "common.hpp"
+
+#include "ipc/sharedMem.hpp"
+
+#include "nlohmann/json.hpp"
+namespace json = nlohmann;
+
+#include <functional>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+/**
+ * Stream buffer exposing the textual chunks of a custom query response, as
+ * they come in over shared memory, as one continuous character stream.
+ *
+ * Every chunk is handed out straight from the receive buffer, so the
+ * response is never assembled as a whole.
+ */
+class ShmTextStreamBuffer: public std::streambuf
+{
+public:
+  using SharedMemory = sharedMem::SHMChannel<sharedMem::Response>;
+
+public:
+  explicit ShmTextStreamBuffer(
+    SharedMemory &channel
+  );
+
+protected:
+  int_type underflow() override;
+
+private:
+  SharedMemory       &mrChannel;
+  sharedMem::Response mResponse;
+  size_t              mPreviousNumber;
+  bool                mDone;
+};
+
+
+/**
+ * SAX handler for the full graph query response (see README).
+ *
+ * Only the primary keys of the active/passive vertices and the endpoints of
+ * non-null pub/sub/send edges are extracted, everything else is skipped
+ * without being materialised. Both the whole-object and the projection form
+ * of the query are understood, i.e. vertices and edge endpoints may either be
+ * objects with a "primaryKey" or plain primary key strings.
+ *
+ * If asked to, the scalar properties of vertex objects (e.g. the member
+ * metadata returned by the neighbourhood query) are kept as well, as one
+ * json object per vertex.
+ */
+class GraphQuerySaxHandler: public json::json_sax<json::json>
+{
+public:
+  enum EdgeType: uint8_t
+  {
+    EDGE_PUB, EDGE_SUB, EDGE_SEND
+  };
+  struct Edge
+  {
+    EdgeType type;
+    PrimaryKey from, to;
+  };
+  using Edges = std::vector<Edge>;
+
+private:
+  enum Section: uint8_t
+  {
+    SECTION_NONE, SECTION_ACTIVE, SECTION_PASSIVE, SECTION_PUB, SECTION_SUB, SECTION_SEND
+  };
+  enum Endpoint: uint8_t
+  {
+    ENDPOINT_NONE, ENDPOINT_FROM, ENDPOINT_TO
+  };
+  struct Frame
+  {
+    bool isArray;
+    std::string key;
+  };
+
+public:
+  explicit GraphQuerySaxHandler(
+    bool withProperties = false
+  );
+
+  bool null() override;
+  bool boolean(bool) override { return true; }
+  bool number_integer(number_integer_t value) override;
+  bool number_unsigned(number_unsigned_t value) override;
+  bool number_float(number_float_t, const string_t &) override { return true; }
+  bool string(string_t &value) override;
+  bool binary(binary_t &) override { return true; }
+  bool start_object(std::size_t) override;
+  bool key(string_t &value) override;
+  bool end_object() override;
+  bool start_array(std::size_t) override;
+  bool end_array() override;
+  bool parse_error(std::size_t position, const std::string &lastToken, const json::detail::exception &exception) override;
+
+  const MemberProxies &getVertices() const { return mVertices; }
+  //! @return the properties of every vertex, in the same order as getVertices, if asked for
+  const std::vector<json::json> &getProperties() const { return mProperties; }
+  const Edges &getEdges() const { return mEdges; }
+
+private:
+  bool isEdgeSection() const { return mSection == SECTION_PUB || mSection == SECTION_SUB || mSection == SECTION_SEND; }
+  bool isVertexObject() const { return (mSection == SECTION_ACTIVE || mSection == SECTION_PASSIVE) && mFrames.size() == mSectionDepth + 2ul && !mFrames.back().isArray; }
+  void addVertex(
+    const std::string &primaryKey
+  );
+  //! @return which edge endpoint a value at the current depth belongs to, if any
+  Endpoint currentEndpoint() const;
+  void setEndpoint(
+    Endpoint endpoint,
+    const std::string &primaryKey
+  );
+
+private:
+  std::vector<Frame>  mFrames;
+  Section             mSection;
+  size_t              mSectionDepth;
+
+  Edge                mCurrentEdge;
+  bool                mCurrentEdgeValid;
+
+  std::string         mCurrentVertex;
+  json::json          mCurrentProperties;
+
+  MemberProxies       mVertices;
+  std::vector<json::json> mProperties;
+  Edges               mEdges;
+
+  const bool          cmWithProperties;
+};
+
+
+/**
+ * Build the graph view of a parsed full graph query response, in O(V + E).
+ *
+ * Edges are resolved through a map of the vertices by key; edges with an
+ * endpoint that is not among the vertices are skipped with a warning.
+ *
+ * @param isIgnoredTopic tells which topics to leave out, along with their edges
+ */
+GraphView assembleGraphView(
+  const GraphQuerySaxHandler &handler,
+  const std::function<bool(const PrimaryKey &)> &isIgnoredTopic
+);
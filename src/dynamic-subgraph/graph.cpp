@@ -76,14 +76,14 @@ void Graph::visualise(const std::atomic<bool> &running, cr::milliseconds loopTar
       {
         const ScopeLock scopedLock(mVerticesMutex);
 
-        char cPrimaryKey[37];
+        char cPrimaryKey[PrimaryKey::STRING_SIZE + 1ul];
         for (const MemberPtr &vertex: mVertices)
         {
-          std::strcpy(cPrimaryKey, vertex->mPrimaryKey.c_str());
+          std::strcpy(cPrimaryKey, vertex->mPrimaryKey.toString().c_str());
           Agnode_t *fromNode = agnode(graph, cPrimaryKey, 1);
           for (const MemberProxy &to: this->getOutgoing(vertex))
           {
-            std::strcpy(cPrimaryKey, to.mPrimaryKey.c_str());
+            std::strcpy(cPrimaryKey, to.mPrimaryKey.toString().c_str());
             Agnode_t *toNode = agnode(graph, cPrimaryKey, 1);
             agedge(graph, fromNode, toNode, NULL, 1);
           }
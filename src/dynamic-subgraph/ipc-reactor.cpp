@@ -0,0 +1,275 @@
+#include "dynamic-subgraph/ipc-reactor.hpp"
+
+#include "ipc/ipc-exceptions.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+
+IpcReactor::IpcReactor(IpcClient &&client):
+  mClient(std::move(client)),
+  mNrRequested(0ul),
+  mRunning(true),
+  mUpdatesRunning(false)
+{
+  LOG_TRACE(LOG_THIS);
+
+  mReceiver = std::thread(&IpcReactor::runReceiver, this, std::cref(mRunning), [this]() { return this->pollResponses(); }, true);
+}
+
+IpcReactor::~IpcReactor()
+{
+  LOG_TRACE(LOG_THIS);
+
+  this->stopUpdateReceiver();
+  this->stopReceiver(mReceiver, mRunning);
+  LOG_DEBUG("IPC reactor stopped.");
+}
+
+std::future<SearchResponse> IpcReactor::sendSearchRequest(const SearchRequest &request, ResponseNotifier notify) const
+{
+  return this->send<SearchResponse>([this, &request](requestId_t &oRequestId) { mClient.sendSearchRequest(request, oRequestId); }, std::move(notify));
+}
+
+std::future<NodeResponse> IpcReactor::sendNodeRequest(const NodeRequest &request, ResponseNotifier notify) const
+{
+  return this->send<NodeResponse>([this, &request](requestId_t &oRequestId) { mClient.sendNodeRequest(request, oRequestId); }, std::move(notify));
+}
+
+std::future<TopicResponse> IpcReactor::sendTopicRequest(const TopicRequest &request, ResponseNotifier notify) const
+{
+  return this->send<TopicResponse>([this, &request](requestId_t &oRequestId) { mClient.sendTopicRequest(request, oRequestId); }, std::move(notify));
+}
+
+std::future<SingleAttributesResponse> IpcReactor::sendSingleAttributesRequest(const SingleAttributesRequest &request, ResponseNotifier notify) const
+{
+  return this->send<SingleAttributesResponse>([this, &request](requestId_t &oRequestId) { mClient.sendSingleAttributesRequest(request, oRequestId); }, std::move(notify));
+}
+
+std::future<CustomMemberResponse> IpcReactor::sendCustomMemberRequest(const CustomMemberRequest &request, ResponseNotifier notify) const
+{
+  return this->send<CustomMemberResponse>([this, &request](requestId_t &oRequestId) { mClient.sendCustomMemberRequest(request, oRequestId); }, std::move(notify));
+}
+
+void IpcReactor::sendUnsubscribeRequest(const UnsubscribeRequest &request) const
+{
+  //! NOTE: the client hands out request ids for these too
+  const std::lock_guard<std::mutex> scopedLock(mClientMutex);
+
+  requestId_t requestId;
+  mClient.sendUnsubscribeRequest(request, requestId);
+}
+
+void IpcReactor::startUpdateReceiver(UpdateHandler handler)
+{
+  LOG_TRACE(LOG_THIS);
+  assert(!mUpdateReceiver.joinable());
+
+  mUpdateHandler = std::move(handler);
+  mUpdatesRunning.store(true);
+  mUpdateReceiver = std::thread(&IpcReactor::runReceiver, this, std::cref(mUpdatesRunning), [this]() { return this->pollUpdates(mUpdateHandler); }, false);
+  LOG_DEBUG("Started the update receiver.");
+}
+
+void IpcReactor::stopUpdateReceiver()
+{
+  LOG_TRACE(LOG_THIS);
+
+  this->stopReceiver(mUpdateReceiver, mUpdatesRunning);
+}
+
+size_t IpcReactor::receiveUpdates(const UpdateHandler &handler)
+{
+  LOG_TRACE(LOG_THIS);
+  assert(!mUpdateReceiver.joinable());
+
+  return this->pollUpdates(handler);
+}
+
+template<typename Response, typename Send>
+std::future<Response> IpcReactor::send(Send &&sendRequest, ResponseNotifier &&notify) const
+{
+  //! NOTE: counted before sending, so the receiver is polling by the time
+  //!       the response can arrive
+  if (mNrRequested.fetch_add(1ul) == 0ul)
+  {
+    const std::lock_guard<std::mutex> scopedLock(mRequestedMutex);
+    mRequestedCondition.notify_one();
+  }
+
+  requestId_t requestId;
+  try
+  {
+    const std::lock_guard<std::mutex> scopedLock(mClientMutex);
+    sendRequest(requestId);
+  }
+  catch (...)
+  {
+    mNrRequested.fetch_sub(1ul);
+    throw;
+  }
+
+  std::promise<Response> promise;
+  std::future<Response> output = promise.get_future();
+
+  //! NOTE: the response might have been routed before the promise exists
+  PromiseShard<Response> &shard = this->getPromiseShard<Response>(requestId);
+  const std::lock_guard<std::mutex> scopedLock(shard.mutex);
+  typename std::unordered_map<requestId_t, EarlyResponse<Response>>::iterator earlyIt = shard.early.find(requestId);
+  if (earlyIt != shard.early.end())
+  {
+    promise.set_value(earlyIt->second.response);
+    shard.early.erase(earlyIt);
+    mNrRequested.fetch_sub(1ul);
+  }
+  else
+    shard.promises.emplace(requestId, PendingResponse<Response>{.promise = std::move(promise), .notify = std::move(notify)});
+
+  return output;
+}
+
+template<typename Response>
+void IpcReactor::route(const Response &response)
+{
+  PromiseShard<Response> &shard = this->getPromiseShard<Response>(response.requestID);
+  const std::lock_guard<std::mutex> scopedLock(shard.mutex);
+
+  typename std::unordered_map<requestId_t, PendingResponse<Response>>::iterator it = shard.promises.find(response.requestID);
+  if (it == shard.promises.end())
+  {
+    const cr::steady_clock::time_point now = cr::steady_clock::now();
+    std::erase_if(shard.early, [&now](const auto &early)
+    {
+      if (now - early.second.arrivedAt < cEarlyExpiry)
+        return false;
+
+      LOG_WARN("Dropping response to request " << early.first << ", no request of this reactor claimed it.");
+      return true;
+    });
+
+    bool inserted;
+    std::tie(std::ignore, inserted) = shard.early.try_emplace(response.requestID, EarlyResponse<Response>{.response = response, .arrivedAt = now});
+    if (!inserted)
+      LOG_WARN("Dropping duplicate response to request " << response.requestID << ".");
+    return;
+  }
+
+  it->second.promise.set_value(response);
+  if (it->second.notify)
+    it->second.notify();
+  shard.promises.erase(it);
+  mNrRequested.fetch_sub(1ul);
+}
+
+void IpcReactor::runReceiver(const std::atomic<bool> &running, const std::function<size_t()> &receive, bool whileRequested)
+{
+  LOG_TRACE(LOG_THIS);
+
+  cr::microseconds idleWait(0);
+  cr::milliseconds errorWait(cMinErrorWait);
+  while (running.load())
+  {
+    size_t nrReceived;
+    try
+    {
+      nrReceived = receive();
+    }
+    catch (const IpcException &except)
+    {
+      //! NOTE: nothing interrupts the polls, so the error is most likely
+      //!       persistent (e.g. the queue got removed) and retrying right
+      //!       away would just spin
+      LOG_ERROR("Receiving from the IPC failed, retrying in " << errorWait.count() << "ms: " << except.what());
+      std::this_thread::sleep_for(errorWait);
+      errorWait = std::min(errorWait * 2, cMaxErrorWait);
+      continue;
+    }
+    errorWait = cMinErrorWait;
+
+    if (nrReceived > 0ul)
+    {
+      idleWait = cr::microseconds(0);
+      continue;
+    }
+
+    if (whileRequested && mNrRequested.load() == 0ul)
+    {
+      std::unique_lock<std::mutex> lock(mRequestedMutex);
+      mRequestedCondition.wait(lock, [this, &running]() { return mNrRequested.load() > 0ul || !running.load(); });
+      idleWait = cr::microseconds(0);
+      continue;
+    }
+
+    idleWait = std::clamp(idleWait * 2, cMinIdleWait, cMaxIdleWait);
+    std::this_thread::sleep_for(idleWait);
+  }
+}
+
+void IpcReactor::stopReceiver(std::thread &receiver, std::atomic<bool> &running)
+{
+  running.store(false);
+  {
+    const std::lock_guard<std::mutex> scopedLock(mRequestedMutex);
+    mRequestedCondition.notify_all();
+  }
+
+  if (receiver.joinable())
+    receiver.join();
+}
+
+size_t IpcReactor::pollResponses()
+{
+  return (
+    this->pollResponse(&IpcClient::receiveSearchResponse) +
+    this->pollResponse(&IpcClient::receiveNodeResponse) +
+    this->pollResponse(&IpcClient::receiveTopicResponse) +
+    this->pollResponse(&IpcClient::receiveSingleAttributesResponse) +
+    this->pollResponse(&IpcClient::receiveCustomMemberResponse)
+  );
+}
+
+template<typename Response>
+size_t IpcReactor::pollResponse(std::optional<Response> (IpcClient::*receive)(bool) const)
+{
+  std::optional<Response> response;
+  {
+    const std::lock_guard<std::mutex> scopedLock(mClientMutex);
+    response = (mClient.*receive)(false);
+  }
+  if (!response.has_value())
+    return 0ul;
+
+  this->route(response.value());
+  return 1ul;
+}
+
+size_t IpcReactor::pollUpdates(const UpdateHandler &handler)
+{
+  return (
+    this->pollUpdate(&IpcClient::receiveNodePublishersToUpdate, handler) +
+    this->pollUpdate(&IpcClient::receiveNodeSubscribersToUpdate, handler) +
+    this->pollUpdate(&IpcClient::receiveNodeIsServerForUpdate, handler) +
+    this->pollUpdate(&IpcClient::receiveNodeIsClientOfUpdate, handler) +
+    this->pollUpdate(&IpcClient::receiveNodeIsActionServerForUpdate, handler) +
+    this->pollUpdate(&IpcClient::receiveNodeIsActionClientOfUpdate, handler) +
+    //! NOTE: NodeTimerToUpdate not currently regarded
+    this->pollUpdate(&IpcClient::receiveNodeStateUpdate, handler) +
+    this->pollUpdate(&IpcClient::receiveTopicPublishersUpdate, handler) +
+    this->pollUpdate(&IpcClient::receiveTopicSubscribersUpdate, handler)
+  );
+}
+
+template<typename Message>
+size_t IpcReactor::pollUpdate(std::optional<Message> (IpcClient::*receive)(bool) const, const UpdateHandler &handler)
+{
+  std::optional<Message> update;
+  {
+    const std::lock_guard<std::mutex> scopedLock(mClientMutex);
+    update = (mClient.*receive)(false);
+  }
+  if (!update.has_value())
+    return 0ul;
+
+  handler(update.value());
+  return 1ul;
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "common.hpp"
+
+#include "ipc/common.hpp"
+#include "ipc/datastructs/information-datastructs.hpp"
+#include "ipc/ipc-client.hpp"
+
+#include <cstddef>
+#include <array>
+#include <future>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <tuple>
+#include <variant>
+#include <vector>
+#include <chrono>
+namespace cr = std::chrono;
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+
+/**
+ * Sole owner of the IPC client, which lets any number of threads have
+ * requests in flight at the same time.
+ *
+ * Requests are sent right away from the calling thread, which gets a future
+ * for the response. The responses are routed to their futures by request id,
+ * so callers neither have to serialise their request/response pairs nor can
+ * they get each other's responses. The promises are sharded by request id,
+ * so routing does not contend on a single lock.
+ *
+ * The client is not documented to be thread safe, so every call of it is
+ * serialised, and none of them blocks: SysV message queues offer no way to
+ * block on several message types at once, nor to be woken up without a
+ * signal. Instead one receiver thread polls every response type without
+ * blocking, backing off while there is nothing to receive and sleeping on a
+ * condition variable while no request is in flight. Updates are polled the
+ * same way by a second receiver thread once startUpdateReceiver is called,
+ * or by the caller of receiveUpdates. Both receivers only check whether to
+ * stop in between polls, so stopping them takes no signal.
+ *
+ * NOTE: futures of responses that did not arrive before the reactor is
+ *       destroyed throw std::future_error (broken promise).
+ */
+class IpcReactor
+{
+public:
+  using Update = std::variant<
+    NodePublishersToUpdate,
+    NodeSubscribersToUpdate,
+    NodeIsServerForUpdate,
+    NodeIsClientOfUpdate,
+    NodeIsActionServerForUpdate,
+    NodeIsActionClientOfUpdate,
+    NodeStateUpdate,
+    TopicPublishersUpdate,
+    TopicSubscribersUpdate
+  >;
+  using UpdateHandler = std::function<void(const Update &)>;
+  using ResponseNotifier = std::function<void()>;
+
+private:
+  static constexpr size_t cNrPromiseShards = 16ul;
+  //! NOTE: bounds of the wait between polls which received nothing, and
+  //!       between polls which failed
+  static constexpr cr::microseconds cMinIdleWait{10},
+                                    cMaxIdleWait{500};
+  static constexpr cr::milliseconds cMinErrorWait{10},
+                                    cMaxErrorWait{1000};
+  //! NOTE: senders claim early responses right after sending, so older ones
+  //!       answer requests this reactor did not send, or answered twice
+  static constexpr cr::seconds      cEarlyExpiry{10};
+
+  template<typename Response>
+  struct EarlyResponse
+  {
+    Response                     response;
+    cr::steady_clock::time_point arrivedAt;
+  };
+  template<typename Response>
+  struct PendingResponse
+  {
+    std::promise<Response> promise;
+    ResponseNotifier       notify;
+  };
+  template<typename Response>
+  struct PromiseShard
+  {
+    std::mutex                                                mutex;
+    std::unordered_map<requestId_t, PendingResponse<Response>> promises;
+    //! responses which arrived before the sender registered their promise
+    std::unordered_map<requestId_t, EarlyResponse<Response>>   early;
+  };
+  template<typename Response>
+  using Promises = std::array<PromiseShard<Response>, cNrPromiseShards>;
+
+public:
+  IpcReactor(
+    IpcClient &&client
+  );
+  IpcReactor(const IpcReactor &) = delete;
+  IpcReactor &operator=(const IpcReactor &) = delete;
+  ~IpcReactor();
+
+  /**
+   * @param notify if set, called by the receiver thread once the response
+   *               is set, e.g. to wake up an Executor (see
+   *               Executor::getNotifier); not called if the response is
+   *               there before this returns
+   */
+  std::future<SearchResponse> sendSearchRequest(
+    const SearchRequest &request,
+    ResponseNotifier notify = ResponseNotifier()
+  ) const;
+  std::future<NodeResponse> sendNodeRequest(
+    const NodeRequest &request,
+    ResponseNotifier notify = ResponseNotifier()
+  ) const;
+  std::future<TopicResponse> sendTopicRequest(
+    const TopicRequest &request,
+    ResponseNotifier notify = ResponseNotifier()
+  ) const;
+  std::future<SingleAttributesResponse> sendSingleAttributesRequest(
+    const SingleAttributesRequest &request,
+    ResponseNotifier notify = ResponseNotifier()
+  ) const;
+  std::future<CustomMemberResponse> sendCustomMemberRequest(
+    const CustomMemberRequest &request,
+    ResponseNotifier notify = ResponseNotifier()
+  ) const;
+  /**
+   * Unsubscriptions are not answered, so there is nothing to wait for.
+   */
+  void sendUnsubscribeRequest(
+    const UnsubscribeRequest &request
+  ) const;
+
+  /**
+   * Receive every update as soon as it arrives, calling handler from the
+   * update receiver thread until stopUpdateReceiver.
+   */
+  void startUpdateReceiver(
+    UpdateHandler handler
+  );
+  void stopUpdateReceiver();
+  /**
+   * Receive at most one update of every type, without blocking.
+   *
+   * @note must not be used while the update receiver runs
+   *
+   * @return number of updates handed to handler
+   */
+  size_t receiveUpdates(
+    const UpdateHandler &handler
+  );
+
+private:
+  template<typename Response, typename Send>
+  std::future<Response> send(
+    Send &&sendRequest,
+    ResponseNotifier &&notify
+  ) const;
+  template<typename Response>
+  void route(
+    const Response &response
+  );
+  /**
+   * Poll with receive until running is unset, backing off while it returns
+   * zero or throws.
+   *
+   * @param whileRequested only poll while there are requests in flight
+   */
+  void runReceiver(
+    const std::atomic<bool> &running,
+    const std::function<size_t()> &receive,
+    bool whileRequested
+  );
+  void stopReceiver(
+    std::thread &receiver,
+    std::atomic<bool> &running
+  );
+  /**
+   * Receive at most one response of every type, without blocking, and route
+   * them.
+   *
+   * @return number of responses received
+   */
+  size_t pollResponses();
+  template<typename Response>
+  size_t pollResponse(
+    std::optional<Response> (IpcClient::*receive)(bool) const
+  );
+  size_t pollUpdates(
+    const UpdateHandler &handler
+  );
+  template<typename Message>
+  size_t pollUpdate(
+    std::optional<Message> (IpcClient::*receive)(bool) const,
+    const UpdateHandler &handler
+  );
+
+  template<typename Response>
+  PromiseShard<Response> &getPromiseShard(
+    requestId_t requestId
+  ) const { return std::get<Promises<Response>>(mPromises)[requestId % cNrPromiseShards]; }
+
+private:
+  IpcClient mClient;
+  mutable std::mutex mClientMutex;
+
+  mutable std::tuple<
+    Promises<SearchResponse>,
+    Promises<NodeResponse>,
+    Promises<TopicResponse>,
+    Promises<SingleAttributesResponse>,
+    Promises<CustomMemberResponse>
+  > mPromises;
+
+  //! NOTE: number of requests sent whose response was not claimed yet, the
+  //!       condition is only notified when it leaves zero
+  mutable std::atomic<size_t> mNrRequested;
+  mutable std::mutex mRequestedMutex;
+  mutable std::condition_variable mRequestedCondition;
+
+  std::atomic<bool> mRunning,
+                    mUpdatesRunning;
+  std::thread   mReceiver,
+                mUpdateReceiver;
+  UpdateHandler mUpdateHandler;
+};
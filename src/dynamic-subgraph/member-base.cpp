@@ -1,12 +1,15 @@
 #include "dynamic-subgraph/member-base.hpp"
 
 #include <cassert>
+#include <utility>
 
 
 Member::AttributeMapping Member::getAttributes() const
 {
   LOG_TRACE(this);
 
+  const ScopeLock scopedLock(mAttributesMutex);
+
   AttributeMapping output;
   for (Attribute &attribute: mmAttributes)
   {
@@ -22,17 +25,38 @@ Member::AttributeMapping Member::getAttributes() const
   return output;
 }
 
-void Member::addAttributeSource(const AttributeDescriptor &attributeName, const SingleAttributesResponse &response)
+Member::Attribute Member::openAttributeSource(const AttributeDescriptor &attributeName, const SingleAttributesResponse &response)
 {
-  LOG_TRACE(this << LOG_VAR(attributeName) "requestId: " << response.requestID << "memAddress: " << response.memAddress);
+  LOG_TRACE(LOG_VAR(attributeName) "requestId: " << response.requestID << "memAddress: " << response.memAddress);
 
   SharedMemory shm(util::parseString(response.memAddress));
   sharedMem::Response shmResponse = MAKE_RESPONSE;
   shm.receive(shmResponse);
   assert(shmResponse.header.type == sharedMem::NUMERICAL);
-  LOG_TRACE(this << "Initial attribute " << attributeName << " value: " << shmResponse.numerical.value);
+  LOG_TRACE("Initial attribute " << attributeName << " value: " << shmResponse.numerical.value);
+
+  return Attribute{
+    .name = attributeName,
+    .sharedMemory = std::move(shm),
+    .requestId = response.requestID,
+    .lastValue = shmResponse.numerical.value
+  };
+}
+
+void Member::addAttributeSource(Attribute &&attribute)
+{
+  LOG_TRACE(this << " attribute: " << attribute.name);
+
+  const ScopeLock scopedLock(mAttributesMutex);
+  mmAttributes.push_back(std::move(attribute));
+}
+
+Member::Attributes Member::takeAttributeSources()
+{
+  LOG_TRACE(this);
 
-  mmAttributes.emplace_back(attributeName, std::move(shm), response.requestID, shmResponse.numerical.value);
+  const ScopeLock scopedLock(mAttributesMutex);
+  return std::exchange(mmAttributes, Attributes());
 }
 
 
@@ -72,12 +96,17 @@ MemberPtr &MemberPtr::operator=(const MemberPtr &other)
 {
   LOG_TRACE(LOG_THIS LOG_VAR(other));
 
-  mpMember = other.mpMember;
-  if (!mpMember)
+  if (this == &other)
     return *this;
 
+  // take the new use before giving up the old one, they might be the same member
+  if (other.mpMember)
+    other.mpUseCounter->increase();
+  if (mpMember)
+    mpUseCounter->decrease();
+
+  mpMember = other.mpMember;
   mpUseCounter = other.mpUseCounter;
-  mpUseCounter->increase();
   LOG_TRACE(*this);
 
   return *this;
@@ -101,6 +130,11 @@ MemberPtr &MemberPtr::operator=(MemberPtr &&other)
 {
   LOG_TRACE(LOG_THIS LOG_VAR(other));
 
+  if (this == &other)
+    return *this;
+  if (mpMember)
+    mpUseCounter->decrease();
+
   mpMember = other.mpMember;
   if (!mpMember)
     return *this;
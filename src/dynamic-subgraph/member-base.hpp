@@ -10,6 +10,8 @@
 
 #include <string>
 #include <map>
+#include <mutex>
+#include <functional>
 #include <iostream>
 
 
@@ -42,14 +44,31 @@ protected:
     PrimaryKey primaryKey
   ):
     mIsTopic(isTopic),
-    mPrimaryKey(primaryKey)
+    mPrimaryKey(primaryKey),
+    mAttributesSubscribed(false),
+    mAttributeGeneration(0ul)
   {}
 
 public:
+  /**
+   * @return latest value of every subscribed attribute, empty if the
+   *         attributes are not subscribed (i.e. the member is not watched)
+   */
   AttributeMapping getAttributes() const;
   void addAttributeSource(
     const AttributeDescriptor &attributeName,
     const SingleAttributesResponse &response
+  ) { this->addAttributeSource(openAttributeSource(attributeName, response)); }
+  /**
+   * Open the shared memory of an attribute subscription and wait for its
+   * initial value; so this blocks, but touches no member.
+   */
+  static Attribute openAttributeSource(
+    const AttributeDescriptor &attributeName,
+    const SingleAttributesResponse &response
+  );
+  void addAttributeSource(
+    Attribute &&attribute
   );
 
   friend std::ostream &operator<<(
@@ -66,7 +85,16 @@ public:
   PrimaryKey          mPrimaryKey;
 
 protected:
+  Attributes takeAttributeSources();
+
+protected:
+  mutable std::mutex  mAttributesMutex;
   mutable Attributes  mmAttributes;
+  //! NOTE: guarded by DataStore::mAttributeSubscriptionMutex
+  bool                mAttributesSubscribed;
+  //! NOTE: guarded by DataStore::mAttributeSubscriptionMutex, bumped whenever
+  //!       the subscription is cancelled
+  size_t              mAttributeGeneration;
 };
 std::ostream &operator<<(std::ostream &stream, const Member *member);
 std::ostream &operator<<(std::ostream &stream, const Member &member);
@@ -80,6 +108,14 @@ public:
   MemberPtr():
     mpMember(nullptr)
   {}
+  /**
+   * Take over a use of member, which the caller already accounted for on
+   * useCounter (see DataStore::acquire and MAKE_MEMBER_PTR).
+   */
+  MemberPtr(
+    Member *member,
+    AtomicCounter *useCounter
+  );
   ~MemberPtr();
   MemberPtr(
     const MemberPtr &other
@@ -107,15 +143,17 @@ public:
   bool operator==(
     const MemberPtr &other
   ) const { return mpMember == other.mpMember; }
+  //! NOTE: needed for ordered containers, otherwise the comparison silently
+  //!       falls back to the implicit bool conversion
+  bool operator<(
+    const MemberPtr &other
+  ) const { return std::less<const Member *>()(mpMember, other.mpMember); }
 
   friend std::ostream &operator<<(
     std::ostream &stream,
     const MemberPtr &member
   );
 
-private:
-  MemberPtr(Member *member, AtomicCounter *useCounter);
-
 private:
   Member        *mpMember;
   AtomicCounter *mpUseCounter;
@@ -135,14 +173,14 @@ public:
     PrimaryKey primaryKey,
     bool isTopic
   ):
-    mPrimaryKey(std::move(primaryKey)),
+    mPrimaryKey(primaryKey),
     mIsTopic(isTopic)
   {}
   MemberProxy(
     const char (&primaryKey)[MAX_STRING_SIZE],
     bool isTopic
   ):
-    mPrimaryKey(util::parseString(primaryKey)),
+    mPrimaryKey(primaryKey),
     mIsTopic(isTopic)
   {}
 
@@ -159,3 +197,21 @@ public:
 };
 using MemberProxies = std::vector<MemberProxy>;
 std::ostream &operator<<(std::ostream &stream, const MemberProxy &proxy);
+
+template<>
+struct std::hash<MemberProxy>
+{
+  //! NOTE: consistent with MemberProxy::operator==, which only compares keys
+  size_t operator()(const MemberProxy &proxy) const noexcept
+  {
+    return std::hash<PrimaryKey>()(proxy.mPrimaryKey);
+  }
+};
+
+//! a graph vertex and the members it has edges to
+struct MemberConnections
+{
+  MemberProxy member;
+  MemberProxies connections;
+};
+using GraphView = std::vector<MemberConnections>;
@@ -55,7 +55,7 @@ void Node::update(const NodeStateUpdate &update)
 }
 
 Node::Node(const NodeResponse &response):
-  Member(false, response.primaryKey),
+  Member(false, PrimaryKey(response.primaryKey)),
   mName(util::parseString(response.name)),
   mPkgName(util::parseString(response.pkgName)),
   mAlive(response.state == sharedMem::State::ACTIVE),
@@ -73,7 +73,7 @@ const Node *asNode(const MemberPtr &member)
 }
 
 Topic::Topic(const TopicResponse &response):
-  Member(true, response.primaryKey),
+  Member(true, PrimaryKey(response.primaryKey)),
   mName(util::parseString(response.name)),
   mType(util::parseString(response.type))
 {
@@ -87,8 +87,8 @@ public:
   struct CommunicationEdge
   {
     CommunicationEdge(
-      PrimaryKey edge,
-      PrimaryKey node
+      const char (&edge)[MAX_STRING_SIZE],
+      const char (&node)[MAX_STRING_SIZE]
     ):
       primaryKey(edge),
       associatedNode{node, false}
@@ -0,0 +1,115 @@
+#include "dynamic-subgraph/mpsc-queue.hpp"
+
+#include "dynamic-subgraph/data-store.hpp"
+
+#include <cassert>
+
+
+template<typename T>
+MpscQueue<T>::MpscQueue(size_t capacity):
+  mCells(std::make_unique<Cell[]>(roundUpToPowerOfTwo(capacity))),
+  mEnqueuePosition(0ul),
+  mDequeuePosition(0ul),
+  mOverflowCount(0ul),
+  mConsumerWaiting(false),
+  mSignal(0),
+  cmMask(roundUpToPowerOfTwo(capacity) - 1ul)
+{
+  for (size_t i = 0ul; i <= cmMask; ++i)
+    mCells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template<typename T>
+bool MpscQueue<T>::push(const T &value)
+{
+  Cell *cell;
+  size_t position = mEnqueuePosition.load(std::memory_order_relaxed);
+  while (true)
+  {
+    cell = &mCells[position & cmMask];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    ptrdiff_t difference = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(position);
+
+    if (difference == 0)
+    {
+      // cell is free for this position, try to claim it
+      if (mEnqueuePosition.compare_exchange_weak(position, position + 1ul, std::memory_order_relaxed))
+        break;
+    }
+    else if (difference < 0)
+    {
+      // cell still holds the value from one lap ago, i.e. the queue is full
+      mOverflowCount.fetch_add(1ul, std::memory_order_relaxed);
+      return false;
+    }
+    else
+      // another producer claimed this position in the meantime
+      position = mEnqueuePosition.load(std::memory_order_relaxed);
+  }
+
+  cell->value = value;
+  cell->sequence.store(position + 1ul, std::memory_order_release);
+
+  //! NOTE: pairs with the fence in waitUntil, so that either the consumer
+  //!       sees the value or we see that it is waiting
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (mConsumerWaiting.load(std::memory_order_relaxed) && mConsumerWaiting.exchange(false, std::memory_order_relaxed))
+    mSignal.release();
+
+  return true;
+}
+
+template<typename T>
+bool MpscQueue<T>::pop(T &oValue)
+{
+  Cell &cell = mCells[mDequeuePosition & cmMask];
+  if (cell.sequence.load(std::memory_order_acquire) != mDequeuePosition + 1ul)
+    return false;
+
+  oValue = cell.value;
+  // hand the cell back to the producers for the next lap
+  cell.sequence.store(mDequeuePosition + cmMask + 1ul, std::memory_order_release);
+  ++mDequeuePosition;
+
+  return true;
+}
+
+template<typename T>
+bool MpscQueue<T>::empty() const
+{
+  return mCells[mDequeuePosition & cmMask].sequence.load(std::memory_order_acquire) != mDequeuePosition + 1ul;
+}
+
+template<typename T>
+bool MpscQueue<T>::waitUntil(Timestamp deadline)
+{
+  if (!empty())
+    return true;
+
+  // drop signals of producers that raced with the end of a previous wait
+  while (mSignal.try_acquire()) {}
+
+  mConsumerWaiting.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (empty())
+    mSignal.try_acquire_until(deadline);
+  mConsumerWaiting.store(false, std::memory_order_relaxed);
+
+  return !empty();
+}
+
+template<typename T>
+size_t MpscQueue<T>::roundUpToPowerOfTwo(size_t value)
+{
+  assert(value > 0ul);
+
+  size_t result = 1ul;
+  while (result < value)
+    result <<= 1;
+  return result;
+}
+
+
+template class MpscQueue<DataStore::ConnectionUpdate>;
+template class MpscQueue<DataStore::ReleasedMember>;
+template class MpscQueue<DataStore::MemberUpdate>;
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <semaphore>
+#include <type_traits>
+
+
+/**
+ * Bounded lock free multi producer, single consumer queue.
+ *
+ * Based on Dmitry Vyukov's bounded queue: every cell carries a sequence
+ * number telling producers and the consumer whether it is free to be written
+ * or ready to be read, so producers only contend on a single fetch-and-add
+ * style CAS of the enqueue position and never wait for the consumer.
+ *
+ * A full queue does not block the producer, push just fails and the failure
+ * is counted, so the owner can fall back to a slower path and report it.
+ *
+ * The consumer can block until something was pushed (or a deadline passed)
+ * with waitUntil. Producers only touch the semaphore if the consumer
+ * announced that it is (about to be) waiting.
+ *
+ * NOTE: pop, empty and waitUntil must only be called from one thread.
+ */
+template<typename T>
+class MpscQueue
+{
+  static_assert(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>);
+
+private:
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+public:
+  /**
+   * @param capacity minimum number of elements the queue can hold, rounded
+   *                 up to the next power of two
+   */
+  explicit MpscQueue(
+    size_t capacity
+  );
+  MpscQueue(const MpscQueue &) = delete;
+  MpscQueue &operator=(const MpscQueue &) = delete;
+
+  /**
+   * @return false if the queue was full, in which case value was not added
+   */
+  bool push(
+    const T &value
+  );
+  /**
+   * @return false if the queue was empty, in which case oValue is untouched
+   */
+  bool pop(
+    T &oValue
+  );
+  bool empty() const;
+  /**
+   * Block until the queue is not empty or the deadline passed.
+   *
+   * @return true if there is something to pop
+   */
+  bool waitUntil(
+    Timestamp deadline
+  );
+
+  /**
+   * @return number of failed pushes since the last call
+   */
+  size_t takeOverflowCount() { return mOverflowCount.exchange(0ul, std::memory_order_relaxed); }
+  size_t capacity() const { return cmMask + 1ul; }
+
+private:
+  static size_t roundUpToPowerOfTwo(
+    size_t value
+  );
+
+private:
+  std::unique_ptr<Cell[]>       mCells;
+  alignas(64) std::atomic<size_t> mEnqueuePosition;
+  alignas(64) size_t            mDequeuePosition;
+  std::atomic<size_t>           mOverflowCount;
+  std::atomic<bool>             mConsumerWaiting;
+  std::counting_semaphore<>     mSignal;
+
+  const size_t                  cmMask;
+};
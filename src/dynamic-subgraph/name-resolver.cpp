@@ -0,0 +1,100 @@
+#include "dynamic-subgraph/name-resolver.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <cstdlib>
+
+
+NameResolver::NameResolver(const json::json &config, DataStore::Ptr dataStorePtr, Callback callback):
+  mpDataStore(dataStorePtr),
+  mCallback(std::move(callback)),
+  cmMinBackoff(config.at(CONFIG_MIN_BACKOFF).get<size_t>()),
+  cmMaxBackoff(config.at(CONFIG_MAX_BACKOFF).get<size_t>())
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(config) LOG_VAR(dataStorePtr));
+
+  if (cmMinBackoff.count() == 0 || cmMaxBackoff < cmMinBackoff)
+  {
+    LOG_FATAL(CONFIG_NAME_RESOLVER "." CONFIG_MIN_BACKOFF " must be positive and not larger than " CONFIG_NAME_RESOLVER "." CONFIG_MAX_BACKOFF ".");
+    std::exit(1);
+  }
+}
+
+void NameResolver::addName(const std::string &name)
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(name));
+
+  const ScopeLock scopedLock(mPendingMutex);
+
+  mPending.push_back(PendingName{
+    .name = name,
+    .nextAttempt = cr::system_clock::now(),
+    .backoff = cmMinBackoff
+  });
+}
+
+void NameResolver::run(const std::atomic<bool> &running, cr::milliseconds loopTargetInterval)
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(running.load()));
+
+  while (running.load())
+  {
+    Timestamp now = cr::system_clock::now();
+    //! NOTE: wake up at least once per cycle, to notice newly added names
+    //!       and that we are supposed to stop
+    Timestamp nextAttempt = std::min(this->resolveDue(now), now + loopTargetInterval);
+    std::this_thread::sleep_until(nextAttempt);
+  }
+}
+
+Timestamp NameResolver::resolveDue(Timestamp now)
+{
+  LOG_TRACE(LOG_THIS);
+
+  // take the due names out, so adding names is not blocked by the searches
+  PendingNames due;
+  {
+    const ScopeLock scopedLock(mPendingMutex);
+
+    PendingNames::iterator dueBegin = std::partition(
+      mPending.begin(), mPending.end(),
+      [now](const PendingName &pending) -> bool
+      {
+        return pending.nextAttempt > now;
+      }
+    );
+    std::move(dueBegin, mPending.end(), std::back_inserter(due));
+    mPending.erase(dueBegin, mPending.end());
+  }
+
+  PendingNames unresolved;
+  for (PendingName &pending: due)
+  {
+    MemberPtr node = mpDataStore->getNodeByName(pending.name);
+    if (node.valid())
+    {
+      LOG_INFO("Resolved " << pending.name << " to " << node);
+      mCallback(std::move(node));
+      continue;
+    }
+
+    LOG_DEBUG("Could not resolve " << pending.name << ", retrying in " << pending.backoff.count() << "ms.");
+    pending.nextAttempt = cr::system_clock::now() + pending.backoff;
+    if (pending.backoff < cmMaxBackoff)
+    {
+      pending.backoff = std::min(pending.backoff * 2, cmMaxBackoff);
+      if (pending.backoff == cmMaxBackoff)
+        LOG_WARN("Still could not resolve " << pending.name << ", is it spelled correctly?");
+    }
+    unresolved.push_back(std::move(pending));
+  }
+
+  const ScopeLock scopedLock(mPendingMutex);
+
+  std::move(unresolved.begin(), unresolved.end(), std::back_inserter(mPending));
+  Timestamp nextAttempt = Timestamp::max();
+  for (const PendingName &pending: mPending)
+    nextAttempt = std::min(nextAttempt, pending.nextAttempt);
+
+  return nextAttempt;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "dynamic-subgraph/data-store.hpp"
+#include "dynamic-subgraph/member-base.hpp"
+#include "common.hpp"
+
+#include "nlohmann/json.hpp"
+namespace json = nlohmann;
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+namespace cr = std::chrono;
+
+
+/**
+ * Resolves node names to members in the background.
+ *
+ * Names which can not be resolved (yet), e.g. because the node was not
+ * started so far or the name is misspelled, are cached as unresolved and
+ * only retried after a backoff, which starts at name-resolver.min-backoff-ms
+ * and doubles with every failed attempt up to name-resolver.max-backoff-ms.
+ * That way neither the caller is blocked by the search requests nor does a
+ * name that never resolves cost an IPC round trip every cycle.
+ *
+ * Once a name is resolved, the callback is called with the member (from the
+ * resolver's thread) and the name is forgotten.
+ */
+class NameResolver
+{
+public:
+  using Callback = std::function<void(MemberPtr)>;
+
+private:
+  struct PendingName
+  {
+    std::string       name;
+    Timestamp         nextAttempt;
+    cr::milliseconds  backoff;
+  };
+  using PendingNames = std::vector<PendingName>;
+
+public:
+  NameResolver(
+    const json::json &config,
+    DataStore::Ptr dataStorePtr,
+    Callback callback
+  );
+
+  /**
+   * Queue a node name for resolution, the first attempt is made right away.
+   */
+  void addName(
+    const std::string &name
+  );
+
+  void run(
+    const std::atomic<bool> &running,
+    cr::milliseconds loopTargetInterval
+  );
+
+private:
+  /**
+   * @return the time of the next due attempt
+   */
+  Timestamp resolveDue(
+    Timestamp now
+  );
+
+private:
+  PendingNames            mPending;
+  std::mutex              mPendingMutex;
+  DataStore::Ptr          mpDataStore;
+  Callback                mCallback;
+
+  const cr::milliseconds  cmMinBackoff,
+                          cmMaxBackoff;
+};
@@ -0,0 +1,72 @@
+#include "dynamic-subgraph/slab-pool.hpp"
+
+#include "dynamic-subgraph/double-linked-list.hpp"
+#include "dynamic-subgraph/members.hpp"
+
+#include <cassert>
+
+
+template<typename T>
+SlabPool<T>::SlabPool(size_t slabSize):
+  mpFreeList(nullptr),
+  mLive(0ul),
+  mHighWaterMark(0ul),
+  cmSlabSize(slabSize)
+{
+  assert(cmSlabSize > 0ul);
+}
+
+template<typename T>
+void *SlabPool<T>::allocate()
+{
+  if (!mpFreeList)
+    addSlab();
+
+  Slot *slot = mpFreeList;
+  mpFreeList = slot->next;
+
+  if (++mLive > mHighWaterMark)
+    mHighWaterMark = mLive;
+
+  return static_cast<void *>(slot->storage);
+}
+
+template<typename T>
+void SlabPool<T>::deallocate(void *pointer)
+{
+  if (!pointer)
+    return;
+  assert(mLive > 0ul);
+
+  Slot *slot = reinterpret_cast<Slot *>(pointer);
+  slot->next = mpFreeList;
+  mpFreeList = slot;
+  --mLive;
+}
+
+template<typename T>
+SlabPool<T>::Statistics SlabPool<T>::getStatistics() const
+{
+  return Statistics{
+    .live = mLive,
+    .slabs = mSlabs.size(),
+    .highWaterMark = mHighWaterMark
+  };
+}
+
+template<typename T>
+void SlabPool<T>::addSlab()
+{
+  Slab slab = std::make_unique<Slot[]>(cmSlabSize);
+
+  // chain up the slots in order so consecutive allocations are adjacent in memory
+  for (size_t i = 0ul; i + 1ul < cmSlabSize; ++i)
+    slab[i].next = &slab[i + 1ul];
+  slab[cmSlabSize - 1ul].next = mpFreeList;
+  mpFreeList = &slab[0];
+
+  mSlabs.push_back(std::move(slab));
+}
+
+template class SlabPool<_Element<Node>>;
+template class SlabPool<_Element<Topic>>;
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <iostream>
+
+
+/**
+ * Typed fixed size allocator, handing out storage for single T's from
+ * contiguous slabs of cmSlabSize elements.
+ *
+ * Slabs are never released before the pool itself is destroyed, so an
+ * address handed out stays valid (and stable) until it is deallocated,
+ * which is what MemberPtr relies upon. Freed slots are kept in an intrusive
+ * LIFO free list so the most recently released (and thus most likely still
+ * cached) slot is reused first.
+ *
+ * NOTE: not thread safe, synchronisation is up to the owner.
+ */
+template<typename T>
+class SlabPool
+{
+public:
+  struct Statistics
+  {
+    size_t live;          // number of currently allocated elements
+    size_t slabs;         // number of slabs allocated so far
+    size_t highWaterMark; // maximum number of simultaneously allocated elements
+
+    friend std::ostream &operator<<(
+      std::ostream &stream,
+      const Statistics &statistics
+    )
+    {
+      stream << "{live: " << statistics.live << ", slabs: " << statistics.slabs << ", high water mark: " << statistics.highWaterMark << '}';
+      return stream;
+    }
+  };
+
+private:
+  union Slot
+  {
+    Slot *next;
+    alignas(T) std::byte storage[sizeof(T)];
+  };
+  using Slab = std::unique_ptr<Slot[]>;
+
+public:
+  explicit SlabPool(
+    size_t slabSize = 64ul
+  );
+  SlabPool(const SlabPool &) = delete;
+  SlabPool &operator=(const SlabPool &) = delete;
+
+  void *allocate();
+  void deallocate(
+    void *pointer
+  );
+
+  Statistics getStatistics() const;
+
+private:
+  void addSlab();
+
+private:
+  std::vector<Slab> mSlabs;
+  Slot             *mpFreeList;
+  size_t            mLive,
+                    mHighWaterMark;
+
+  const size_t      cmSlabSize;
+};
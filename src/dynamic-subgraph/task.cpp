@@ -0,0 +1,192 @@
+#include "dynamic-subgraph/task.hpp"
+#include "dynamic-subgraph/data-store.hpp"
+
+#include <cassert>
+#include <algorithm>
+
+
+template<typename T>
+std::coroutine_handle<> Task<T>::promise_type::FinalAwaiter::await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+{
+  // symmetric transfer back to whoever awaits us, if anybody does so far
+  std::coroutine_handle<> continuation = handle.promise().continuation;
+  return (continuation ? continuation : std::noop_coroutine());
+}
+
+template<typename T>
+Task<T>::~Task()
+{
+  if (mHandle)
+    mHandle.destroy();
+}
+
+template<typename T>
+std::coroutine_handle<> Task<T>::await_suspend(std::coroutine_handle<> awaiting) noexcept
+{
+  promise_type &promise = mHandle.promise();
+  promise.continuation = awaiting;
+  //! NOTE: a task started by the executor already is scheduled or parked,
+  //!       so it must not be resumed from here
+  if (promise.started)
+    return std::noop_coroutine();
+
+  promise.started = true;
+  return mHandle;
+}
+
+template<typename T>
+T Task<T>::result()
+{
+  assert(mHandle.done());
+
+  promise_type &promise = mHandle.promise();
+  if (promise.exception)
+    std::rethrow_exception(promise.exception);
+  return promise.take();
+}
+
+template<typename R>
+bool FutureAwaiter<R>::await_ready() const
+{
+  return mFuture.wait_for(cr::seconds(0)) == std::future_status::ready;
+}
+
+template<typename R>
+void FutureAwaiter<R>::await_suspend(std::coroutine_handle<> awaiting)
+{
+  //! NOTE: the awaiter lives in the suspended coroutine's frame, so it stays
+  //!       valid until the coroutine is resumed
+  mExecutor.park(
+    awaiting,
+    [this]() -> bool
+    {
+      return mFuture.wait_for(cr::seconds(0)) == std::future_status::ready;
+    }
+  );
+}
+
+template<typename T>
+T Executor::run(Task<T> task)
+{
+  LOG_TRACE(LOG_THIS);
+
+  this->start(task);
+  while (!task.done())
+  {
+    if (mReady.empty())
+    {
+      this->poll();
+      continue;
+    }
+
+    std::coroutine_handle<> handle = mReady.front();
+    mReady.pop_front();
+    handle.resume();
+  }
+
+  return task.result();
+}
+
+template<typename T>
+void Executor::start(Task<T> &task)
+{
+  typename Task<T>::promise_type &promise = task.mHandle.promise();
+  if (promise.started)
+    return;
+
+  promise.started = true;
+  mReady.push_back(task.mHandle);
+}
+
+template<typename T>
+Task<std::vector<T>> Executor::whenAll(std::vector<Task<T>> tasks)
+{
+  for (Task<T> &task: tasks)
+    this->start(task);
+
+  //! NOTE: every task has to be awaited, even if one of them failed, as they
+  //!       can't be destroyed while running
+  std::vector<T> output;
+  output.reserve(tasks.size());
+  std::exception_ptr exception;
+  for (Task<T> &task: tasks)
+  {
+    try
+    {
+      output.push_back(co_await task);
+    }
+    catch (...)
+    {
+      if (!exception)
+        exception = std::current_exception();
+    }
+  }
+  if (exception)
+    std::rethrow_exception(exception);
+
+  co_return output;
+}
+
+void Executor::park(std::coroutine_handle<> handle, std::function<bool()> isReady)
+{
+  mParked.push_back(Parked{
+    .handle = handle,
+    .isReady = std::move(isReady)
+  });
+}
+
+void Executor::poll()
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(mParked.size()));
+
+  //! NOTE: otherwise the task run waits for can never finish
+  assert(!mParked.empty());
+
+  std::unique_lock<std::mutex> lock(mNotifyMutex);
+  while (true)
+  {
+    //! NOTE: a future set after this is counted, so the wait below won't miss it
+    const size_t nrNotifications = mNrNotifications;
+    lock.unlock();
+
+    std::vector<Parked>::iterator stillParked = std::stable_partition(
+      mParked.begin(), mParked.end(),
+      [](const Parked &parked) -> bool
+      {
+        return !parked.isReady();
+      }
+    );
+    for (std::vector<Parked>::iterator it = stillParked; it != mParked.end(); ++it)
+      mReady.push_back(it->handle);
+    mParked.erase(stillParked, mParked.end());
+    if (!mReady.empty())
+      return;
+
+    // nothing can continue, so block until something might
+    lock.lock();
+    mNotifyCondition.wait(lock, [this, nrNotifications]() { return mNrNotifications != nrNotifications; });
+  }
+}
+
+void Executor::notify()
+{
+  {
+    const std::lock_guard<std::mutex> scopedLock(mNotifyMutex);
+    ++mNrNotifications;
+  }
+  mNotifyCondition.notify_one();
+}
+
+template class Task<void>;
+template class Task<MemberPtr>;
+template class Task<Members>;
+template class Task<DataStore::GraphView>;
+template class FutureAwaiter<SearchResponse>;
+template class FutureAwaiter<NodeResponse>;
+template class FutureAwaiter<TopicResponse>;
+template class FutureAwaiter<SingleAttributesResponse>;
+template class FutureAwaiter<CustomMemberResponse>;
+template MemberPtr Executor::run(Task<MemberPtr>);
+template void Executor::run(Task<void>);
+template void Executor::start(Task<MemberPtr> &);
+template Task<Members> Executor::whenAll(std::vector<Task<MemberPtr>>);
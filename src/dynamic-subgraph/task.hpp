@@ -0,0 +1,211 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <cstddef>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <future>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <utility>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+namespace cr = std::chrono;
+
+
+class Executor;
+
+template<typename T>
+struct TaskResult
+{
+  std::optional<T> value;
+
+  void return_value(T result) { value.emplace(std::move(result)); }
+  T take() { return std::move(value.value()); }
+};
+template<>
+struct TaskResult<void>
+{
+  void return_void() {}
+  void take() {}
+};
+
+/**
+ * Lazily started coroutine with a result of type T.
+ *
+ * A task starts running when it is first awaited, or when it is handed to
+ * Executor::start, which lets several tasks run at the same time and only
+ * await their results later on. Whoever awaits a task is resumed once it
+ * finished, exceptions thrown by the task are rethrown there.
+ *
+ * NOTE: a started task must be run to completion before it is destroyed.
+ */
+template<typename T>
+class Task
+{
+public:
+  struct promise_type: TaskResult<T>
+  {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr      exception;
+    bool                    started = false;
+
+    struct FinalAwaiter
+    {
+      bool await_ready() const noexcept { return false; }
+      std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<promise_type> handle
+      ) noexcept;
+      void await_resume() const noexcept {}
+    };
+
+    Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { exception = std::current_exception(); }
+  };
+  using Handle = std::coroutine_handle<promise_type>;
+
+public:
+  Task(Task &&other) noexcept: mHandle(std::exchange(other.mHandle, nullptr)) {}
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+  ~Task();
+
+  bool done() const { return mHandle.done(); }
+
+  bool await_ready() const noexcept { return mHandle.done(); }
+  std::coroutine_handle<> await_suspend(
+    std::coroutine_handle<> awaiting
+  ) noexcept;
+  T await_resume() { return this->result(); }
+
+private:
+  explicit Task(Handle handle): mHandle(handle) {}
+
+  T result();
+
+private:
+  friend class Executor;
+
+  Handle mHandle;
+};
+
+/**
+ * Awaits a future (i.e. an IPC response) by parking the awaiting coroutine
+ * in the executor until the future is ready.
+ *
+ * NOTE: whoever sets the future has to call the executor's notifier
+ *       afterwards (see Executor::getNotifier), otherwise the executor might
+ *       not notice.
+ */
+template<typename R>
+class FutureAwaiter
+{
+public:
+  FutureAwaiter(
+    Executor &executor,
+    std::future<R> &&future
+  ): mExecutor(executor), mFuture(std::move(future)) {}
+
+  bool await_ready() const;
+  void await_suspend(
+    std::coroutine_handle<> awaiting
+  );
+  R await_resume() { return mFuture.get(); }
+
+private:
+  Executor &mExecutor;
+  std::future<R> mFuture;
+};
+
+/**
+ * Single threaded executor for tasks.
+ *
+ * Coroutines waiting for IPC responses are parked, while everything else
+ * that is ready to continue is resumed in order. Only if nothing at all can
+ * continue the executor blocks, until it is notified that one of the parked
+ * futures got ready, so hundreds of requests can be in flight from a single
+ * thread without spawning any.
+ *
+ * NOTE: not thread safe, tasks are run on the thread calling run; only the
+ *       notifier may be called from any thread.
+ */
+class Executor
+{
+private:
+  struct Parked
+  {
+    std::coroutine_handle<> handle;
+    std::function<bool()>   isReady;
+  };
+
+public:
+  Executor() = default;
+  Executor(const Executor &) = delete;
+  Executor &operator=(const Executor &) = delete;
+
+  /**
+   * Run task and everything it starts until task is done.
+   *
+   * @return the result of task
+   */
+  template<typename T>
+  T run(
+    Task<T> task
+  );
+  /**
+   * Let task run alongside the awaiting coroutine, its result still has to
+   * be awaited.
+   */
+  template<typename T>
+  void start(
+    Task<T> &task
+  );
+  /**
+   * Start all tasks at once and await all of their results.
+   *
+   * @return the results, in the same order as tasks
+   */
+  template<typename T>
+  Task<std::vector<T>> whenAll(
+    std::vector<Task<T>> tasks
+  );
+  template<typename R>
+  FutureAwaiter<R> wait(
+    std::future<R> &&future
+  ) { return FutureAwaiter<R>(*this, std::move(future)); }
+  /**
+   * @return callback to be called, from any thread, once a future awaited
+   *         by this executor is set (e.g. IpcReactor::sendNodeRequest's
+   *         notify)
+   */
+  std::function<void()> getNotifier() { return [this]() { this->notify(); }; }
+
+  void park(
+    std::coroutine_handle<> handle,
+    std::function<bool()> isReady
+  );
+
+private:
+  /**
+   * Move every parked coroutine which can continue to the ready queue,
+   * blocking if none can.
+   */
+  void poll();
+  void notify();
+
+private:
+  std::deque<std::coroutine_handle<>> mReady;
+  std::vector<Parked> mParked;
+
+  //! NOTE: counts the notifications, so poll can tell whether there was one
+  //!       since it last checked the parked futures
+  std::mutex              mNotifyMutex;
+  std::condition_variable mNotifyCondition;
+  size_t                  mNrNotifications = 0ul;
+};
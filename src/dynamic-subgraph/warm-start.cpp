@@ -0,0 +1,149 @@
+#include "dynamic-subgraph/warm-start.hpp"
+
+#include <fstream>
+#include <cerrno>
+#include <cstring>
+#include <type_traits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+static_assert(std::is_trivially_copyable_v<WarmStartFile::MemberRecord> && alignof(WarmStartFile::MemberRecord) == 1ul);
+static_assert(std::is_trivially_copyable_v<WarmStartFile::VertexRecord> && alignof(WarmStartFile::VertexRecord) == 1ul);
+static_assert(std::is_trivially_copyable_v<WarmStartFile::EdgeRecord> && alignof(WarmStartFile::EdgeRecord) == 1ul);
+
+std::unique_ptr<WarmStartFile> WarmStartFile::load(const fs::path &path)
+{
+  LOG_TRACE(LOG_VAR(path));
+
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1)
+  {
+    if (errno == ENOENT)
+      LOG_INFO("No warm start snapshot at " << path << ", starting cold.")
+    else
+      LOG_WARN("Failed to open warm start snapshot " << path << ": " << std::strerror(errno));
+    return nullptr;
+  }
+
+  struct stat fileState;
+  if (::fstat(fd, &fileState) == -1)
+  {
+    LOG_WARN("Failed to stat warm start snapshot " << path << ": " << std::strerror(errno));
+    ::close(fd);
+    return nullptr;
+  }
+  const size_t size = static_cast<size_t>(fileState.st_size);
+  if (size < sizeof(Header))
+  {
+    LOG_WARN("Warm start snapshot " << path << " is truncated, ignoring it.");
+    ::close(fd);
+    return nullptr;
+  }
+
+  //! NOTE: the mapping stays valid after closing the file descriptor
+  void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    LOG_WARN("Failed to map warm start snapshot " << path << ": " << std::strerror(errno));
+    return nullptr;
+  }
+
+  // from here on the destructor takes care of unmapping
+  std::unique_ptr<WarmStartFile> output(new WarmStartFile(mapping, size));
+  const Header &header = *output->mpHeader;
+  if (std::memcmp(header.magic, cmMagic, sizeof(cmMagic)) != 0 || header.version != cmVersion)
+  {
+    LOG_WARN("Warm start snapshot " << path << " has an unknown format, ignoring it.");
+    return nullptr;
+  }
+  if (size != sizeof(Header) + header.nrMembers * sizeof(MemberRecord) + header.nrVertices * sizeof(VertexRecord) + header.nrEdges * sizeof(EdgeRecord))
+  {
+    LOG_WARN("Warm start snapshot " << path << " does not match its header, ignoring it.");
+    return nullptr;
+  }
+
+  const uint8_t *position = static_cast<const uint8_t *>(mapping) + sizeof(Header);
+  output->mMembers = std::span<const MemberRecord>(reinterpret_cast<const MemberRecord *>(position), header.nrMembers);
+  position += header.nrMembers * sizeof(MemberRecord);
+  output->mVertices = std::span<const VertexRecord>(reinterpret_cast<const VertexRecord *>(position), header.nrVertices);
+  position += header.nrVertices * sizeof(VertexRecord);
+  output->mEdges = std::span<const EdgeRecord>(reinterpret_cast<const EdgeRecord *>(position), header.nrEdges);
+
+  //! NOTE: try_emplace keeps the first record of a name, like a scan would
+  for (const MemberRecord &member: output->mMembers)
+    (member.isTopic ? output->mTopicNames : output->mNodeNames).try_emplace(
+      std::string_view(member.name, ::strnlen(member.name, sizeof(member.name))),
+      member.primaryKey
+    );
+
+  return output;
+}
+
+bool WarmStartFile::write(const fs::path &path, const Contents &contents)
+{
+  LOG_TRACE(LOG_VAR(path) LOG_VAR(contents.members.size()) LOG_VAR(contents.vertices.size()) LOG_VAR(contents.edges.size()));
+
+  Header header{
+    .magic = {},
+    .version = cmVersion,
+    .reserved = 0u,
+    .writtenAt = cr::system_clock::now().time_since_epoch().count(),
+    .rosoutKey = contents.rosoutKey,
+    .parameterEventsKey = contents.parameterEventsKey,
+    .nrMembers = contents.members.size(),
+    .nrVertices = contents.vertices.size(),
+    .nrEdges = contents.edges.size()
+  };
+  std::memcpy(header.magic, cmMagic, sizeof(cmMagic));
+
+  fs::path temporaryPath(path);
+  temporaryPath += ".tmp";
+  {
+    std::ofstream file(temporaryPath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(contents.members.data()), contents.members.size() * sizeof(MemberRecord));
+    file.write(reinterpret_cast<const char *>(contents.vertices.data()), contents.vertices.size() * sizeof(VertexRecord));
+    file.write(reinterpret_cast<const char *>(contents.edges.data()), contents.edges.size() * sizeof(EdgeRecord));
+    file.close();
+    if (file.fail())
+    {
+      LOG_ERROR("Failed to write warm start snapshot " << temporaryPath << ": " << std::strerror(errno));
+      return false;
+    }
+  }
+
+  std::error_code error;
+  fs::rename(temporaryPath, path, error);
+  if (error)
+  {
+    LOG_ERROR("Failed to replace warm start snapshot " << path << ": " << error.message());
+    return false;
+  }
+
+  return true;
+}
+
+WarmStartFile::WarmStartFile(const void *mapping, size_t size):
+  mpMapping(mapping),
+  mSize(size),
+  mpHeader(static_cast<const Header *>(mapping))
+{}
+
+WarmStartFile::~WarmStartFile()
+{
+  ::munmap(const_cast<void *>(mpMapping), mSize);
+}
+
+std::optional<PrimaryKey> WarmStartFile::findName(std::string_view name, bool isTopic) const
+{
+  const std::unordered_map<std::string_view, PrimaryKey> &names = (isTopic ? mTopicNames : mNodeNames);
+  auto it = names.find(name);
+  if (it == names.end())
+    return std::nullopt;
+
+  return it->second;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "primary-key.hpp"
+#include "common.hpp"
+
+#include "ipc/common.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <filesystem>
+namespace fs = std::filesystem;
+
+
+/**
+ * On-disk snapshot of what the data store knew when it was written, so a
+ * restarted pipeline does not have to rediscover everything over the IPC.
+ *
+ * The file is a fixed header followed by flat arrays of members, topology
+ * vertices and topology edges. It is written to a temporary file that is
+ * renamed over the old one afterwards, so readers never see a partially
+ * written snapshot, and read through a read-only memory mapping, so only
+ * the parts which are actually looked at are paged in.
+ *
+ * NOTE: everything in here may be outdated, the data store validates it
+ *       against the IPC before relying on it for longer.
+ */
+class WarmStartFile
+{
+public:
+  //! NOTE: all records are byte aligned, so they can be used right from the mapping
+  struct MemberRecord
+  {
+    PrimaryKey  primaryKey;
+    uint8_t     isTopic;
+    char        name[MAX_STRING_SIZE];
+  };
+  struct VertexRecord
+  {
+    PrimaryKey  primaryKey;
+    uint8_t     isTopic;
+  };
+  struct EdgeRecord
+  {
+    PrimaryKey  from,
+                to;
+    uint8_t     fromIsTopic,
+                toIsTopic;
+  };
+  struct Contents
+  {
+    PrimaryKey                rosoutKey,
+                              parameterEventsKey;
+    std::vector<MemberRecord> members;
+    std::vector<VertexRecord> vertices;
+    std::vector<EdgeRecord>   edges;
+  };
+
+private:
+  struct Header
+  {
+    char            magic[8];
+    uint32_t        version;
+    uint32_t        reserved;
+    Timestamp::rep  writtenAt;
+    PrimaryKey      rosoutKey,
+                    parameterEventsKey;
+    uint64_t        nrMembers,
+                    nrVertices,
+                    nrEdges;
+  };
+
+public:
+  /**
+   * Map the snapshot at path.
+   *
+   * @return nullptr if there is no (valid) snapshot at path
+   */
+  static std::unique_ptr<WarmStartFile> load(
+    const fs::path &path
+  );
+  /**
+   * Atomically replace the snapshot at path with contents.
+   *
+   * @return false if writing failed, in which case the old snapshot is kept
+   */
+  static bool write(
+    const fs::path &path,
+    const Contents &contents
+  );
+
+  WarmStartFile(const WarmStartFile &) = delete;
+  WarmStartFile &operator=(const WarmStartFile &) = delete;
+  ~WarmStartFile();
+
+  Timestamp getWrittenAt() const { return Timestamp(Timestamp::duration(mpHeader->writtenAt)); }
+  const PrimaryKey &getRosoutKey() const { return mpHeader->rosoutKey; }
+  const PrimaryKey &getParameterEventsKey() const { return mpHeader->parameterEventsKey; }
+  std::span<const MemberRecord> getMembers() const { return mMembers; }
+  std::span<const VertexRecord> getVertices() const { return mVertices; }
+  std::span<const EdgeRecord> getEdges() const { return mEdges; }
+
+  /**
+   * Look up a member by name, in the index built when loading.
+   */
+  std::optional<PrimaryKey> findName(
+    std::string_view name,
+    bool isTopic
+  ) const;
+
+private:
+  WarmStartFile(
+    const void *mapping,
+    size_t size
+  );
+
+private:
+  const void                   *mpMapping;
+  size_t                        mSize;
+  const Header                 *mpHeader;
+  std::span<const MemberRecord> mMembers;
+  std::span<const VertexRecord> mVertices;
+  std::span<const EdgeRecord>   mEdges;
+  //! NOTE: the names point into the mapping
+  std::unordered_map<std::string_view, PrimaryKey> mNodeNames,
+                                                   mTopicNames;
+
+  static constexpr char cmMagic[8] = {'F', 'D', 'L', 'W', 'A', 'R', 'M', '\0'};
+  static constexpr uint32_t cmVersion = 1u;
+};
@@ -5,69 +5,114 @@
 #include <algorithm>
 
 
-Watchlist::Watchlist(const json::json &config, DataStore::Ptr dataStorePtr):
+Watchlist::Watchlist(DataStore::Ptr dataStorePtr):
   mpDataStore(dataStorePtr)
 {
-  LOG_TRACE(LOG_THIS LOG_VAR(config) LOG_VAR(dataStorePtr));
+  LOG_TRACE(LOG_THIS LOG_VAR(dataStorePtr));
+}
+
+void Watchlist::addMember(const MemberProxy &member, WatchlistMemberType type)
+{
+  LOG_TRACE(LOG_THIS << member << " type: " << (type == TYPE_NORMAL ? "normal" : ( type == TYPE_INITIAL ? "initial" : "blindspot")));
 
-  if (config.is_null() ||
-      (config.is_array() && config.empty()))
+  if (this->filterNew({member}).empty())
     return;
-  config.get_to(mInitialMemberNames);
 
-  //! TODO: when this also accepts topics eventually, we should probably clean from ignored topics
+  //! NOTE: resolve and subscribe outside of the lock, see addMembers
+  MemberPtr memberPtr = mpDataStore->get(member);
+  mpDataStore->subscribeAttributes({memberPtr});
+
+  Members resolvedMembers;
+  resolvedMembers.push_back(std::move(memberPtr));
+  this->addResolved(std::move(resolvedMembers), type);
 }
 
-void Watchlist::addMember(const MemberProxy &member, WatchlistMemberType type)
+void Watchlist::addMember(MemberPtr member, WatchlistMemberType type)
 {
   LOG_TRACE(LOG_THIS << member << " type: " << (type == TYPE_NORMAL ? "normal" : ( type == TYPE_INITIAL ? "initial" : "blindspot")));
 
-  if (member.mIsTopic && mpDataStore->checkTopicPrimaryIgnored(member.mPrimaryKey))
-  {
-    LOG_DEBUG("Requested ignored member " << member << ", not adding to watchlist.");
+  if (!member.valid() || this->contains(member->mPrimaryKey))
     return;
-  }
 
-  const ScopeLock scopeLock(mMembersMutex);
+  //! NOTE: subscribe outside of the lock and before adding, see addMembers
+  mpDataStore->subscribeAttributes({member});
 
-  InternalMembers::iterator it = std::find_if(
-    mMembers.begin(), mMembers.end(),
-    [&member](const InternalMembers::value_type &internalMember) -> bool
-    {
-      return internalMember.first->mPrimaryKey == member.mPrimaryKey;
-    }
-  );
-  if (it == mMembers.end())
+  Members resolvedMembers;
+  resolvedMembers.push_back(std::move(member));
+  this->addResolved(std::move(resolvedMembers), type);
+}
+
+void Watchlist::addMembers(const MemberProxies &members, WatchlistMemberType type)
+{
+  LOG_TRACE(LOG_THIS LOG_VAR(members) " type: " << (type == TYPE_NORMAL ? "normal" : ( type == TYPE_INITIAL ? "initial" : "blindspot")));
+
+  MemberProxies newMembers = this->filterNew(members);
+  if (newMembers.empty())
     return;
 
-  LOG_TRACE("Adding member " << member << " to watchlist");
-  MemberPtr memberPtr = mpDataStore->get(member);
+  //! NOTE: resolve all members in one batch and outside of the lock, so
+  //!       getMembers is not blocked by IPC round trips
+  Members resolvedMembers = mpDataStore->getMany(newMembers);
+  //! NOTE: subscribe before adding them, the fault detection expects
+  //!       watchlist members to have attributes
+  mpDataStore->subscribeAttributes(resolvedMembers);
 
-  bool emplaced;
-  std::tie(it, emplaced) = mMembers.emplace(std::move(memberPtr), type);
-  assert(emplaced);
+  this->addResolved(std::move(resolvedMembers), type);
 }
 
-void Watchlist::addMember(MemberPtr member, WatchlistMemberType type)
+Task<void> Watchlist::coAddMembers(Executor &executor, MemberProxies members, WatchlistMemberType type)
 {
-  LOG_TRACE(LOG_THIS << member << " type: " << (type == TYPE_NORMAL ? "normal" : ( type == TYPE_INITIAL ? "initial" : "blindspot")));
+  LOG_TRACE(LOG_THIS LOG_VAR(members) " type: " << (type == TYPE_NORMAL ? "normal" : ( type == TYPE_INITIAL ? "initial" : "blindspot")));
+
+  MemberProxies newMembers = this->filterNew(members);
+  if (newMembers.empty())
+    co_return;
+
+  // every member is resolved by its own task, all of them at once
+  std::vector<Task<MemberPtr>> resolutions;
+  resolutions.reserve(newMembers.size());
+  for (const MemberProxy &member: newMembers)
+    resolutions.push_back(mpDataStore->coGet(executor, member));
+  Members resolvedMembers = co_await executor.whenAll(std::move(resolutions));
+  co_await mpDataStore->coSubscribeAttributes(executor, resolvedMembers);
 
+  this->addResolved(std::move(resolvedMembers), type);
+}
+
+MemberProxies Watchlist::filterNew(const MemberProxies &members)
+{
   const ScopeLock scopeLock(mMembersMutex);
 
-  InternalMembers::iterator it = std::find_if(
-    mMembers.begin(), mMembers.end(),
-    [&member](const InternalMembers::value_type &internalMember) -> bool
+  MemberProxies output;
+  for (const MemberProxy &member: members)
+  {
+    if (member.mIsTopic && mpDataStore->checkTopicPrimaryIgnored(member.mPrimaryKey))
     {
-      return internalMember.first == member;
+      LOG_DEBUG("Requested ignored member " << member << ", not adding to watchlist.");
+      continue;
     }
-  );
-  if (it == mMembers.end())
-    return;
+    if (this->get(member.mPrimaryKey) != mMembers.end() ||
+        std::find(output.begin(), output.end(), member) != output.end())
+      continue;
+
+    output.push_back(member);
+  }
 
-  LOG_TRACE("Adding member " << member << " to watchlist");
-  bool emplaced;
-  std::tie(it, emplaced) = mMembers.emplace(std::move(member), type);
-  assert(emplaced);
+  return output;
+}
+
+void Watchlist::addResolved(Members &&resolvedMembers, WatchlistMemberType type)
+{
+  const ScopeLock scopeLock(mMembersMutex);
+  for (MemberPtr &member: resolvedMembers)
+  {
+    if (!member.valid())
+      continue;
+
+    LOG_TRACE("Adding member " << member << " to watchlist");
+    //! NOTE: if the member got added concurrently this is a no-op
+    mMembers.emplace(std::move(member), type);
+  }
 }
 
 Members Watchlist::getMembers()
@@ -76,8 +121,6 @@ Members Watchlist::getMembers()
 
   const ScopeLock scopeLock(mMembersMutex);
 
-  tryInitialise();
-
   Members output;
   output.reserve(mMembers.size());
   std::transform(
@@ -103,42 +146,37 @@ bool Watchlist::contains(const PrimaryKey &member)
 void Watchlist::reset()
 {
   LOG_TRACE(LOG_THIS);
-  const ScopeLock scopeLock(mMembersMutex);
-
-  mMembers.clear();
-}
 
-bool Watchlist::notifyUsed(const PrimaryKey &member)
-{
-  LOG_TRACE(LOG_THIS LOG_VAR(member));
-  const ScopeLock scopedLock(mMembersMutex);
+  Members removedMembers;
+  {
+    const ScopeLock scopeLock(mMembersMutex);
 
-  InternalMembers::iterator it = this->get(member);
-  if (it == mMembers.end() ||
-      it->second != TYPE_BLINDSPOT)
-    return false;
+    removedMembers.reserve(mMembers.size());
+    for (const InternalMembers::value_type &element: mMembers)
+      removedMembers.push_back(element.first);
+    mMembers.clear();
+  }
 
-  mMembers.erase(it);
-  return true;
+  mpDataStore->unsubscribeAttributes(removedMembers);
 }
 
-void Watchlist::tryInitialise()
+bool Watchlist::notifyUsed(const PrimaryKey &member)
 {
-  LOG_TRACE(LOG_THIS);
-
-  if (mInitialMemberNames.empty())
-    return;
+  LOG_TRACE(LOG_THIS LOG_VAR(member));
 
-  for (auto it = mInitialMemberNames.begin(); it != mInitialMemberNames.end();)
+  MemberPtr removedMember;
   {
-    MemberPtr node = mpDataStore->getNodeByName(*it);
-    if (!node.valid())
-    {
-      ++it;
-      continue;
-    }
+    const ScopeLock scopedLock(mMembersMutex);
+
+    InternalMembers::iterator it = this->get(member);
+    if (it == mMembers.end() ||
+        it->second != TYPE_BLINDSPOT)
+      return false;
 
-    mMembers.emplace(std::move(node), TYPE_INITIAL);
-    it = mInitialMemberNames.erase(it);
+    removedMember = it->first;
+    mMembers.erase(it);
   }
+
+  mpDataStore->unsubscribeAttributes({removedMember});
+  return true;
 }
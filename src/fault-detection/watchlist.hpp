@@ -2,6 +2,7 @@
 
 #include "dynamic-subgraph/members.hpp"
 #include "dynamic-subgraph/data-store.hpp"
+#include "dynamic-subgraph/task.hpp"
 
 #include "nlohmann/json.hpp"
 namespace json = nlohmann;
@@ -24,7 +25,6 @@ private:
 
 public:
   Watchlist(
-    const json::json &config,
     DataStore::Ptr dataStorePtr
   );
 
@@ -36,6 +36,19 @@ public:
     MemberPtr member,
     WatchlistMemberType type = TYPE_NORMAL
   );
+  void addMembers(
+    const MemberProxies &members,
+    WatchlistMemberType type = TYPE_NORMAL
+  );
+  /**
+   * Like addMembers, but every member is resolved concurrently by its own
+   * task on executor.
+   */
+  Task<void> coAddMembers(
+    Executor &executor,
+    MemberProxies members,
+    WatchlistMemberType type = TYPE_NORMAL
+  );
 
   bool contains(
     const PrimaryKey &member
@@ -48,7 +61,17 @@ public:
   );
 
 private:
-  void tryInitialise();
+  /**
+   * @return the members which are neither ignored nor watched already,
+   *         without duplicates
+   */
+  MemberProxies filterNew(
+    const MemberProxies &members
+  );
+  void addResolved(
+    Members &&resolvedMembers,
+    WatchlistMemberType type
+  );
 
   InternalMembers::iterator get(
     const PrimaryKey &member
@@ -64,7 +87,6 @@ private:
   }
 
 private:
-  std::vector<std::string> mInitialMemberNames;
   InternalMembers mMembers;
   std::mutex mMembersMutex;
   DataStore::Ptr mpDataStore;
@@ -0,0 +1,103 @@
+#include "primary-key.hpp"
+
+#include "common.hpp"
+
+
+//! NOTE: the digits of random keys are about as often letters as numbers,
+//!       so a table beats branching on the character class
+static constexpr std::array<int8_t, 256> cHexValues = []()
+{
+  std::array<int8_t, 256> values;
+  values.fill(-1);
+  for (int c = '0'; c <= '9'; ++c)
+    values[c] = static_cast<int8_t>(c - '0');
+  for (int c = 'a'; c <= 'f'; ++c)
+    values[c] = values[c - 'a' + 'A'] = static_cast<int8_t>(c - 'a' + 10);
+  return values;
+}();
+
+static int hexValue(char c)
+{
+  return cHexValues[static_cast<unsigned char>(c)];
+}
+
+PrimaryKey::PrimaryKey(std::string_view uuid):
+  mBytes{}
+{
+  if (uuid.empty())
+    return;
+
+  Bytes bytes{};
+  // the canonical 8-4-4-4-12 form is all the IPC ever hands out
+  if (uuid.size() == STRING_SIZE && uuid[8] == '-' && uuid[13] == '-' && uuid[18] == '-' && uuid[23] == '-')
+  {
+    static constexpr size_t cOffsets[SIZE] = {0, 2, 4, 6, 9, 11, 14, 16, 19, 21, 24, 26, 28, 30, 32, 34};
+    //! NOTE: a negative (invalid) value sets the sign bit, so that is checked once
+    int values = 0;
+    for (size_t i = 0ul; i < SIZE; ++i)
+    {
+      int high = hexValue(uuid[cOffsets[i]]),
+          low = hexValue(uuid[cOffsets[i] + 1ul]);
+      values |= high | low;
+      bytes[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+    if (values >= 0)
+    {
+      mBytes = bytes;
+      return;
+    }
+    bytes = Bytes{};
+  }
+
+  // anything else is parsed digit by digit, skipping dashes
+  size_t nrDigits = 0ul;
+  for (char c: uuid)
+  {
+    if (c == '-')
+      continue;
+
+    int value = hexValue(c);
+    if (value < 0 || nrDigits == 2ul * SIZE)
+    {
+      LOG_ERROR("Invalid primary key '" << uuid << "', using empty key instead.");
+      return;
+    }
+
+    bytes[nrDigits / 2ul] |= static_cast<uint8_t>(value << ((nrDigits % 2ul == 0ul) ? 4 : 0));
+    ++nrDigits;
+  }
+  if (nrDigits != 2ul * SIZE)
+  {
+    LOG_ERROR("Invalid primary key '" << uuid << "', using empty key instead.");
+    return;
+  }
+
+  mBytes = bytes;
+}
+
+std::string PrimaryKey::toString() const
+{
+  if (this->empty())
+    return std::string();
+
+  static constexpr char cDigits[] = "0123456789abcdef";
+  std::string output;
+  output.reserve(STRING_SIZE);
+  for (size_t i = 0ul; i < SIZE; ++i)
+  {
+    // canonical 8-4-4-4-12 grouping
+    if (i == 4ul || i == 6ul || i == 8ul || i == 10ul)
+      output.push_back('-');
+    output.push_back(cDigits[mBytes[i] >> 4]);
+    output.push_back(cDigits[mBytes[i] & 0x0F]);
+  }
+
+  return output;
+}
+
+std::ostream &operator<<(std::ostream &stream, const PrimaryKey &key)
+{
+  stream << key.toString();
+
+  return stream;
+}
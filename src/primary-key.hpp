@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <compare>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <iostream>
+
+
+/**
+ * Binary representation of the UUIDs used as primary keys by the IPC/DB.
+ *
+ * The canonical textual form ("xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx") is 36
+ * characters long and thus too long for the small string optimisation, so
+ * every copy of a std::string key used to allocate. This type is trivially
+ * copyable, compares as two machine words and hashes without looking at text.
+ * A default constructed (all zero) key is considered empty, which is what the
+ * IPC returns as textual empty string when a search did not yield anything.
+ */
+class PrimaryKey
+{
+public:
+  static constexpr size_t SIZE = 16ul;
+  static constexpr size_t STRING_SIZE = 36ul;
+  using Bytes = std::array<uint8_t, SIZE>;
+
+public:
+  constexpr PrimaryKey():
+    mBytes{}
+  {}
+  explicit PrimaryKey(
+    std::string_view uuid
+  );
+  template<size_t N>
+  explicit PrimaryKey(
+    const char (&uuid)[N]
+  ):
+    PrimaryKey(std::string_view(uuid, ::strnlen(uuid, N)))
+  {}
+
+  bool empty() const { return *this == PrimaryKey(); }
+  std::string toString() const;
+  const Bytes &bytes() const { return mBytes; }
+
+  bool operator==(const PrimaryKey &other) const = default;
+  std::strong_ordering operator<=>(const PrimaryKey &other) const = default;
+
+  friend std::ostream &operator<<(
+    std::ostream &stream,
+    const PrimaryKey &key
+  );
+
+private:
+  Bytes mBytes;
+};
+std::ostream &operator<<(std::ostream &stream, const PrimaryKey &key);
+
+static_assert(sizeof(PrimaryKey) == PrimaryKey::SIZE);
+static_assert(std::is_trivially_copyable_v<PrimaryKey>);
+
+
+template<>
+struct std::hash<PrimaryKey>
+{
+  size_t operator()(const PrimaryKey &key) const noexcept
+  {
+    //! NOTE: the keys are (mostly random) v4 UUIDs, so folding both halves
+    //!       together is plenty to get a good distribution
+    uint64_t low, high;
+    std::memcpy(&low, key.bytes().data(), sizeof(low));
+    std::memcpy(&high, key.bytes().data() + sizeof(low), sizeof(high));
+    return static_cast<size_t>(low ^ (high * 0x9E3779B97F4A7C15ull));
+  }
+};